@@ -0,0 +1,436 @@
+#include "CPUFluidSolver.h"
+
+namespace
+{
+	template<typename T>
+	CStdGrid<T> Resample(const CStdGrid<T> &source, const std::int32_t newWidth, const std::int32_t newHeight)
+	{
+		CStdGrid<T> result{newWidth, newHeight};
+		for (std::int32_t y{0}; y < newHeight; ++y)
+		{
+			for (std::int32_t x{0}; x < newWidth; ++x)
+			{
+				result(x, y) = source.Sample({(x + 0.5f) / newWidth, (y + 0.5f) / newHeight});
+			}
+		}
+
+		return result;
+	}
+
+	using Boundaries = std::array<BoundaryCondition, 4>;
+
+	bool IsPeriodic(const Boundaries &boundaries, const BoundarySide side)
+	{
+		return boundaries[static_cast<std::size_t>(side)] == BoundaryCondition::Periodic;
+	}
+
+	// BoundarySource of boundary.glsl
+	glm::ivec2 BoundarySource(const std::int32_t x, const std::int32_t y, const std::int32_t width, const std::int32_t height, const Boundaries &boundaries)
+	{
+		glm::ivec2 source{x, y};
+
+		if (x == 0)
+		{
+			source.x = IsPeriodic(boundaries, BoundarySide::Left) ? width - 2 : 1;
+		}
+		else if (x == width - 1)
+		{
+			source.x = IsPeriodic(boundaries, BoundarySide::Right) ? 1 : width - 2;
+		}
+
+		if (y == 0)
+		{
+			source.y = IsPeriodic(boundaries, BoundarySide::Bottom) ? height - 2 : 1;
+		}
+		else if (y == height - 1)
+		{
+			source.y = IsPeriodic(boundaries, BoundarySide::Top) ? 1 : height - 2;
+		}
+
+		return source;
+	}
+
+	// BoundaryValue of boundary.glsl
+	glm::vec2 BoundaryValue(const std::int32_t x, const std::int32_t y, const std::int32_t width, const std::int32_t height, const Boundaries &boundaries, const glm::vec2 &inflow, const glm::vec2 &value)
+	{
+		BoundaryCondition condition{BoundaryCondition::Periodic};
+		glm::vec2 normal{0.0f};
+
+		if (x == 0 || x == width - 1)
+		{
+			condition = boundaries[static_cast<std::size_t>(x == 0 ? BoundarySide::Left : BoundarySide::Right)];
+			normal = glm::vec2{1.0f, 0.0f};
+		}
+
+		if (condition == BoundaryCondition::Periodic && (y == 0 || y == height - 1))
+		{
+			condition = boundaries[static_cast<std::size_t>(y == 0 ? BoundarySide::Bottom : BoundarySide::Top)];
+			normal = glm::vec2{0.0f, 1.0f};
+		}
+
+		switch (condition)
+		{
+		case BoundaryCondition::NoSlip:
+			return -value;
+		case BoundaryCondition::FreeSlip:
+			return value - 2.0f * normal * glm::dot(value, normal);
+		case BoundaryCondition::Inflow:
+			return inflow;
+		default:
+			return value;
+		}
+	}
+
+	float SquaredNorm(const float value) { return value * value; }
+	float SquaredNorm(const glm::vec2 &value) { return glm::dot(value, value); }
+	float MaxAbs(const float value) { return std::abs(value); }
+	float MaxAbs(const glm::vec2 &value) { return std::max(std::abs(value.x), std::abs(value.y)); }
+
+	template<typename T>
+	CStdSwappableGrid<T> Resample(const CStdSwappableGrid<T> &source, const std::int32_t newWidth, const std::int32_t newHeight)
+	{
+		CStdSwappableGrid<T> result{newWidth, newHeight};
+		result.GetFront() = Resample(source.GetFront(), newWidth, newHeight);
+		return result;
+	}
+}
+
+CStdCPUFluidSolver::CStdCPUFluidSolver(const Variables &vars, const std::int32_t width, const std::int32_t height, const std::size_t numThreads)
+	: CStdFluidSolver{vars, width, height},
+	  threadPool{numThreads},
+	  velocityBuffer{width, height},
+	  pressureBuffer{width, height},
+	  vorticityBuffer{width, height},
+	  divergenceBuffer{width, height},
+	  temporaryBuffer{width, height},
+	  velocitySolvers{threadPool},
+	  pressureSolvers{threadPool},
+	  spectralSolver{threadPool}
+{
+}
+
+template<typename Func>
+void CStdCPUFluidSolver::ForEachCell(Func &&function)
+{
+	threadPool.ForEachCell(width, height, std::forward<Func>(function));
+}
+
+// sor.frag, updating in place is safe because every half sweep only reads cells of the other color, which needs even grid sizes
+template<typename T>
+void CStdCPUFluidSolver::SolveRedBlackSOR(CStdGrid<T> &field, const CStdGrid<T> &initialValue, const float alpha, const float beta)
+{
+	const float inverseBeta{1.0f / beta};
+	const float omega{vars.sorOmega};
+
+	for (std::size_t i{0}; i < vars.sorIterations; ++i)
+	{
+		for (std::int32_t parity{0}; parity < 2; ++parity)
+		{
+			threadPool.ParallelFor(0, height, [&](const std::int32_t begin, const std::int32_t end)
+			{
+				for (std::int32_t y{begin}; y < end; ++y)
+				{
+					for (std::int32_t x{(y + parity) & 1}; x < width; x += 2)
+					{
+						const T gaussSeidel{(field.Fetch(x - 1, y) + field.Fetch(x + 1, y) + field.Fetch(x, y - 1) + field.Fetch(x, y + 1) + alpha * initialValue(x, y)) * inverseBeta};
+						field(x, y) += omega * (gaussSeidel - field(x, y));
+					}
+				}
+			});
+		}
+	}
+}
+
+// residual_norm.comp, returns the statistics without the iteration count
+template<typename T>
+PoissonStatistics CStdCPUFluidSolver::ComputeResidual(const CStdGrid<T> &field, const CStdGrid<T> &initialValue, const float alpha, const float beta)
+{
+	// x: sum of r^2, y: max |r|, z: sum of (alpha * b)^2
+	const glm::dvec3 norms{threadPool.ParallelReduce<glm::dvec3>(0, height, [&](const std::int32_t y)
+	{
+		glm::dvec3 row{0.0};
+		for (std::int32_t x{0}; x < width; ++x)
+		{
+			const T source{alpha * initialValue(x, y)};
+			const T residual{source - (beta * field(x, y) - (field.Fetch(x - 1, y) + field.Fetch(x + 1, y) + field.Fetch(x, y - 1) + field.Fetch(x, y + 1)))};
+			row += glm::dvec3{SquaredNorm(residual), 0.0, SquaredNorm(source)};
+			row.y = std::max(row.y, static_cast<double>(MaxAbs(residual)));
+		}
+
+		return row;
+	})};
+
+	PoissonStatistics statistics;
+	statistics.residual = norms.z > 0.0 ? static_cast<float>(std::sqrt(norms.x / norms.z)) : 0.0f;
+	statistics.maxResidual = static_cast<float>(norms.y);
+	return statistics;
+}
+
+// jacobi.frag, chebyshev.frag
+template<typename T>
+void CStdCPUFluidSolver::SolvePoissonSystem(CStdSwappableGrid<T> &swappableBuffer, const CStdGrid<T> &initialValue, const float alpha, const float beta, PoissonSolvers<T> &solvers, const PoissonSystem system)
+{
+	PoissonStatistics &statistics{poissonStatistics[static_cast<std::size_t>(system)]};
+
+	if (vars.poissonSolver == PoissonSolver::Multigrid)
+	{
+		solvers.multigrid.Solve(swappableBuffer, initialValue, alpha, beta, vars);
+		statistics = ComputeResidual(swappableBuffer.GetFront(), initialValue, alpha, beta);
+		statistics.iterations = vars.multigridCycles;
+		return;
+	}
+
+	if (vars.poissonSolver == PoissonSolver::ConjugateGradient)
+	{
+		const std::size_t iterations{solvers.conjugateGradient.Solve(swappableBuffer.GetFront(), initialValue, alpha, beta, vars)};
+		statistics = ComputeResidual(swappableBuffer.GetFront(), initialValue, alpha, beta);
+		statistics.iterations = iterations;
+		return;
+	}
+
+	if (UsesRedBlackSOR())
+	{
+		SolveRedBlackSOR(swappableBuffer.GetFront(), initialValue, alpha, beta);
+		statistics = ComputeResidual(swappableBuffer.GetFront(), initialValue, alpha, beta);
+		statistics.iterations = vars.sorIterations;
+		return;
+	}
+
+	const float inverseBeta{1.0f / beta};
+	const bool chebyshev{vars.poissonSolver == PoissonSolver::Chebyshev};
+	CStdChebyshevWeights weights{beta, width, height, vars.poissonMaxIterations};
+
+	statistics = PoissonStatistics{};
+
+	for (std::size_t iteration{1}; iteration <= vars.poissonMaxIterations; ++iteration)
+	{
+		const auto &field = swappableBuffer.GetFront();
+		auto &result = swappableBuffer.GetBack();
+		const float omega{chebyshev ? weights.Next() : 1.0f};
+		const bool weighted{chebyshev && iteration > 1};
+
+		ForEachCell([&](const std::int32_t x, const std::int32_t y)
+		{
+			const T jacobi{(field.Fetch(x - 1, y) + field.Fetch(x + 1, y) + field.Fetch(x, y - 1) + field.Fetch(x, y + 1) + alpha * initialValue(x, y)) * inverseBeta};
+
+			// The back buffer still holds x(k - 1), see chebyshev.frag
+			result(x, y) = weighted ? result(x, y) + omega * (jacobi - result(x, y)) : jacobi;
+		});
+
+		swappableBuffer.SwapBuffers();
+
+		const bool last{iteration == vars.poissonMaxIterations};
+		if (last || (vars.poissonTolerance > 0.0f && iteration % vars.poissonCheckInterval == 0))
+		{
+			statistics = ComputeResidual(swappableBuffer.GetFront(), initialValue, alpha, beta);
+			statistics.iterations = iteration;
+
+			if (statistics.residual <= vars.poissonTolerance)
+			{
+				break;
+			}
+		}
+	}
+}
+
+void CStdCPUFluidSolver::Step(const float dt, const ImpulseState &impulseState)
+{
+	SetBounds();
+	Advect(dt);
+
+	if (impulseState.IsActive())
+	{
+		AddImpulse(impulseState);
+	}
+
+	ComputeVorticity();
+	SetBounds();
+	AddVorticity();
+
+	// Diffusion
+	const float alpha{(vars.gridScale * vars.gridScale) / (vars.viscosity * dt)};
+	const float beta{alpha + 4.0f};
+	temporaryBuffer = velocityBuffer.GetFront();
+	SolvePoissonSystem(velocityBuffer, temporaryBuffer, alpha, beta, velocitySolvers, PoissonSystem::Diffusion);
+
+	// Projection
+	ComputeDivergence();
+	if (vars.projection == ProjectionMethod::Spectral)
+	{
+		spectralSolver.Solve(pressureBuffer.GetFront(), divergenceBuffer, -vars.gridScale * vars.gridScale, 4.0f);
+	}
+	else
+	{
+		SolvePoissonSystem(pressureBuffer, divergenceBuffer, -vars.gridScale * vars.gridScale, 4.0f, pressureSolvers, PoissonSystem::Pressure);
+	}
+	SubtractGradient();
+
+	SetBounds();
+}
+
+void CStdCPUFluidSolver::Resize(const std::int32_t newWidth, const std::int32_t newHeight)
+{
+	SetSize(newWidth, newHeight);
+
+	velocityBuffer = Resample(velocityBuffer, width, height);
+	pressureBuffer = Resample(pressureBuffer, width, height);
+	vorticityBuffer = CStdGrid<float>{width, height};
+	divergenceBuffer = CStdGrid<float>{width, height};
+	temporaryBuffer = CStdGrid<glm::vec2>{width, height};
+}
+
+std::vector<glm::vec2> CStdCPUFluidSolver::GetVelocity() const
+{
+	return velocityBuffer.GetFront().GetData();
+}
+
+// advection.frag
+void CStdCPUFluidSolver::Advect(const float dt)
+{
+	const auto &velocity = velocityBuffer.GetFront();
+	auto &result = velocityBuffer.GetBack();
+
+	ForEachCell([&](const std::int32_t x, const std::int32_t y)
+	{
+		const glm::vec2 position{TexCoord(x, y) - dt * vars.gridScale * velocity(x, y)};
+		result(x, y) = vars.advectionDissipation * velocity.Sample(position);
+	});
+
+	velocityBuffer.SwapBuffers();
+}
+
+// add_impulse.frag and add_radial_impulse.frag
+void CStdCPUFluidSolver::AddImpulse(const ImpulseState &impulseState)
+{
+	const auto diff = impulseState.Delta;
+	const glm::vec2 force{std::clamp(diff.x, -vars.gridScale, vars.gridScale), std::clamp(diff.y, -vars.gridScale, vars.gridScale)};
+	const glm::vec2 position{glm::vec2{impulseState.CurrentPos.x, impulseState.CurrentPos.y} * gridScale};
+	const bool radial{impulseState.Radial};
+
+	auto &velocity = velocityBuffer.GetFront();
+
+	ForEachCell([&](const std::int32_t x, const std::int32_t y)
+	{
+		const glm::vec2 delta{position - TexCoord(x, y)};
+		const float falloff{std::exp(-glm::dot(delta, delta) / vars.splatRadius)};
+
+		if (!radial)
+		{
+			velocity(x, y) += force * falloff;
+		}
+		else if (delta != glm::vec2{0.0f})
+		{
+			velocity(x, y) += glm::normalize(delta) * falloff;
+		}
+	});
+}
+
+// vorticity.frag
+void CStdCPUFluidSolver::ComputeVorticity()
+{
+	const auto &velocity = velocityBuffer.GetFront();
+	const float halfScale{0.5f / vars.gridScale};
+
+	ForEachCell([&](const std::int32_t x, const std::int32_t y)
+	{
+		const glm::vec2 &R{velocity.Fetch(x + 1, y)};
+		const glm::vec2 &L{velocity.Fetch(x - 1, y)};
+		const glm::vec2 &B{velocity.Fetch(x, y - 1)};
+		const glm::vec2 &T{velocity.Fetch(x, y + 1)};
+
+		vorticityBuffer(x, y) = (R.y - L.y) * halfScale - (T.x - B.x) * halfScale;
+	});
+}
+
+// add_vorticity.frag
+void CStdCPUFluidSolver::AddVorticity()
+{
+	static constexpr float Epsilon{0.00024414f};
+	static constexpr float DeltaT{1.0f};
+
+	const auto &velocity = velocityBuffer.GetFront();
+	auto &result = velocityBuffer.GetBack();
+	const float halfScale{0.5f / vars.gridScale};
+
+	ForEachCell([&](const std::int32_t x, const std::int32_t y)
+	{
+		const float R{vorticityBuffer.Fetch(x + 1, y)};
+		const float L{vorticityBuffer.Fetch(x - 1, y)};
+		const float B{vorticityBuffer.Fetch(x, y - 1)};
+		const float T{vorticityBuffer.Fetch(x, y + 1)};
+		const float C{vorticityBuffer(x, y)};
+
+		glm::vec2 force{glm::vec2{std::abs(T) - std::abs(B), std::abs(R) - std::abs(L)} * halfScale};
+		force /= std::sqrt(std::max(Epsilon, glm::dot(force, force)));
+		force *= vars.vorticity * C * glm::vec2{1.0f, -1.0f};
+
+		result(x, y) = velocity(x, y) + DeltaT * force;
+	});
+
+	velocityBuffer.SwapBuffers();
+}
+
+// divergence.frag
+void CStdCPUFluidSolver::ComputeDivergence()
+{
+	const auto &velocity = velocityBuffer.GetFront();
+	const float halfScale{0.5f / vars.gridScale};
+
+	ForEachCell([&](const std::int32_t x, const std::int32_t y)
+	{
+		const float R{velocity.Fetch(x + 1, y).x};
+		const float L{velocity.Fetch(x - 1, y).x};
+		const float B{velocity.Fetch(x, y - 1).y};
+		const float T{velocity.Fetch(x, y + 1).y};
+
+		divergenceBuffer(x, y) = (R - L) * halfScale + (T - B) * halfScale;
+	});
+}
+
+// gradient.frag and subtract.frag
+void CStdCPUFluidSolver::SubtractGradient()
+{
+	const auto &pressure = pressureBuffer.GetFront();
+	auto &velocity = velocityBuffer.GetFront();
+	const float halfScale{0.5f / vars.gridScale};
+
+	ForEachCell([&](const std::int32_t x, const std::int32_t y)
+	{
+		const float R{pressure.Fetch(x + 1, y)};
+		const float L{pressure.Fetch(x - 1, y)};
+		const float B{pressure.Fetch(x, y - 1)};
+		const float T{pressure.Fetch(x, y + 1)};
+
+		velocity(x, y) -= glm::vec2{R - L, T - B} * halfScale;
+	});
+}
+
+// Ghost cell rules of boundary.glsl, rim cells only read interior cells and can be updated in place
+void CStdCPUFluidSolver::SetBounds()
+{
+	auto &velocity = velocityBuffer.GetFront();
+
+	const auto update = [&](const std::int32_t x, const std::int32_t y)
+	{
+		const glm::ivec2 source{BoundarySource(x, y, width, height, vars.boundaries)};
+		velocity(x, y) = BoundaryValue(x, y, width, height, vars.boundaries, vars.inflowVelocity, velocity(source.x, source.y));
+	};
+
+	threadPool.ParallelFor(0, width, [&](const std::int32_t begin, const std::int32_t end)
+	{
+		for (std::int32_t x{begin}; x < end; ++x)
+		{
+			update(x, height - 1);
+			update(x, 0);
+		}
+	});
+
+	threadPool.ParallelFor(0, height, [&](const std::int32_t begin, const std::int32_t end)
+	{
+		for (std::int32_t y{begin}; y < end; ++y)
+		{
+			update(0, y);
+			update(width - 1, y);
+		}
+	});
+}
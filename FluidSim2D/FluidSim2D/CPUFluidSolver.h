@@ -0,0 +1,59 @@
+#pragma once
+
+#include "ConjugateGradient.h"
+#include "FluidSolver.h"
+#include "Grid.h"
+#include "Multigrid.h"
+#include "SpectralSolver.h"
+#include "ThreadPool.h"
+
+// Headless reference implementation of CStdGLFluidSolver on plain float arrays.
+// Every method mirrors one of the fragment shaders, rows are split across a thread pool.
+class CStdCPUFluidSolver : public CStdFluidSolver
+{
+	// Solver state kept per field, the coarse levels and CG vectors are reused between steps
+	template<typename T>
+	struct PoissonSolvers
+	{
+		explicit PoissonSolvers(CStdThreadPool &threadPool) : multigrid{threadPool}, conjugateGradient{threadPool} {}
+
+		CStdMultigridSolver<T> multigrid;
+		CStdConjugateGradientSolver<T> conjugateGradient;
+	};
+
+public:
+	CStdCPUFluidSolver(const Variables &vars, std::int32_t width, std::int32_t height, std::size_t numThreads = std::thread::hardware_concurrency());
+
+public:
+	void Step(float dt, const ImpulseState &impulseState) override;
+	void Resize(std::int32_t newWidth, std::int32_t newHeight) override;
+	std::vector<glm::vec2> GetVelocity() const override;
+
+	std::size_t GetNumThreads() const { return threadPool.GetNumThreads(); }
+
+private:
+	template<typename Func> void ForEachCell(Func &&function);
+	glm::vec2 TexCoord(std::int32_t x, std::int32_t y) const { return {(x + 0.5f) * gridScale.x, (y + 0.5f) * gridScale.y}; }
+
+	void Advect(float dt);
+	void AddImpulse(const ImpulseState &impulseState);
+	void ComputeVorticity();
+	void AddVorticity();
+	void ComputeDivergence();
+	void SubtractGradient();
+	void SetBounds();
+	template<typename T> void SolveRedBlackSOR(CStdGrid<T> &field, const CStdGrid<T> &initialValue, float alpha, float beta);
+	template<typename T> void SolvePoissonSystem(CStdSwappableGrid<T> &swappableBuffer, const CStdGrid<T> &initialValue, float alpha, float beta, PoissonSolvers<T> &solvers, PoissonSystem system);
+	template<typename T> PoissonStatistics ComputeResidual(const CStdGrid<T> &field, const CStdGrid<T> &initialValue, float alpha, float beta);
+
+private:
+	CStdThreadPool threadPool;
+	CStdSwappableGrid<glm::vec2> velocityBuffer;
+	CStdSwappableGrid<float> pressureBuffer;
+	CStdGrid<float> vorticityBuffer;
+	CStdGrid<float> divergenceBuffer;
+	CStdGrid<glm::vec2> temporaryBuffer;
+	PoissonSolvers<glm::vec2> velocitySolvers;
+	PoissonSolvers<float> pressureSolvers;
+	CStdSpectralSolver spectralSolver;
+};
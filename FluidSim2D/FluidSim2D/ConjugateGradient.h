@@ -0,0 +1,168 @@
+#pragma once
+
+#include <cmath>
+
+#include "FluidSolver.h"
+#include "Grid.h"
+#include "ThreadPool.h"
+
+// Preconditioned conjugate gradient for the systems SolvePoissonSystem handles:
+//   beta * x - (xL + xR + xB + xT) = alpha * b
+// with wrapping neighbours, the same periodic system as the GL solver and the other CPU solvers.
+// Vector fields are solved as one block diagonal system, so the CG scalars are summed over both channels.
+// The preconditioner is the incomplete Poisson approximation M^-1 = K * K^T with K = I + L / beta,
+// see pcg.comp for the GL counterpart.
+template<typename T>
+class CStdConjugateGradientSolver
+{
+public:
+	explicit CStdConjugateGradientSolver(CStdThreadPool &threadPool) : threadPool{threadPool} {}
+
+public:
+	// Returns the number of iterations run
+	std::size_t Solve(CStdGrid<T> &solution, const CStdGrid<T> &rightHandSide, const float alpha, const float beta, const Variables &vars)
+	{
+		EnsureGrids(solution.GetWidth(), solution.GetHeight());
+
+		// r = alpha * b - A * x0
+		ForEachCell([&](const std::int32_t x, const std::int32_t y)
+		{
+			residual(x, y) = alpha * rightHandSide(x, y) - Apply(solution, x, y, beta);
+		});
+
+		const double sourceNorm{std::abs(alpha) * std::sqrt(Dot(rightHandSide, rightHandSide))};
+
+		// The periodic pressure system is singular, keep r orthogonal to its null space, the constant field
+		if (beta <= 4.0f)
+		{
+			RemoveMean(residual);
+		}
+
+		Precondition(residual, preconditioned, beta);
+		direction = preconditioned;
+		double rz{Dot(residual, preconditioned)};
+
+		std::size_t iteration{0};
+		while (iteration < vars.pcgMaxIterations)
+		{
+			ForEachCell([&](const std::int32_t x, const std::int32_t y)
+			{
+				product(x, y) = Apply(direction, x, y, beta);
+			});
+
+			const double pq{Dot(direction, product)};
+			const float a{pq != 0.0 ? static_cast<float>(rz / pq) : 0.0f};
+
+			ForEachCell([&](const std::int32_t x, const std::int32_t y)
+			{
+				solution(x, y) += a * direction(x, y);
+				residual(x, y) -= a * product(x, y);
+			});
+
+			Precondition(residual, preconditioned, beta);
+			const double rzNew{Dot(residual, preconditioned)};
+			const float b{rz != 0.0 ? static_cast<float>(rzNew / rz) : 0.0f};
+			rz = rzNew;
+
+			ForEachCell([&](const std::int32_t x, const std::int32_t y)
+			{
+				direction(x, y) = preconditioned(x, y) + b * direction(x, y);
+			});
+
+			++iteration;
+
+			if (iteration % vars.pcgCheckInterval == 0 && std::sqrt(Dot(residual, residual)) <= vars.pcgTolerance * sourceNorm)
+			{
+				break;
+			}
+		}
+
+		return iteration;
+	}
+
+private:
+	void EnsureGrids(const std::int32_t width, const std::int32_t height)
+	{
+		if (residual.GetWidth() == width && residual.GetHeight() == height)
+		{
+			return;
+		}
+
+		residual = CStdGrid<T>{width, height};
+		preconditioned = CStdGrid<T>{width, height};
+		direction = CStdGrid<T>{width, height};
+		product = CStdGrid<T>{width, height};
+		temporary = CStdGrid<T>{width, height};
+	}
+
+	template<typename Func> void ForEachCell(Func &&function)
+	{
+		threadPool.ForEachCell(residual.GetWidth(), residual.GetHeight(), std::forward<Func>(function));
+	}
+
+	static T Apply(const CStdGrid<T> &field, const std::int32_t x, const std::int32_t y, const float beta)
+	{
+		return beta * field(x, y) - (field.Fetch(x - 1, y) + field.Fetch(x + 1, y) + field.Fetch(x, y - 1) + field.Fetch(x, y + 1));
+	}
+
+	static float Component(const float value) { return value; }
+	static float Component(const glm::vec2 &value) { return value.x + value.y; }
+
+	double Dot(const CStdGrid<T> &lhs, const CStdGrid<T> &rhs)
+	{
+		return threadPool.ParallelReduce<double>(0, lhs.GetHeight(), [&](const std::int32_t y)
+		{
+			double sum{0.0};
+			for (std::int32_t x{0}; x < lhs.GetWidth(); ++x)
+			{
+				sum += Component(lhs(x, y) * rhs(x, y));
+			}
+
+			return sum;
+		});
+	}
+
+	void RemoveMean(CStdGrid<T> &field)
+	{
+		const T sum{threadPool.ParallelReduce<T>(0, field.GetHeight(), [&](const std::int32_t y)
+		{
+			T rowSum{};
+			for (std::int32_t x{0}; x < field.GetWidth(); ++x)
+			{
+				rowSum += field(x, y);
+			}
+
+			return rowSum;
+		})};
+
+		const T mean{sum / static_cast<float>(field.GetWidth() * field.GetHeight())};
+		ForEachCell([&](const std::int32_t x, const std::int32_t y)
+		{
+			field(x, y) -= mean;
+		});
+	}
+
+	// z = K * K^T * r, the neighbours wrap around like in Apply and in pcg.comp
+	void Precondition(const CStdGrid<T> &field, CStdGrid<T> &result, const float beta)
+	{
+		const float inverseBeta{1.0f / beta};
+
+		ForEachCell([&](const std::int32_t x, const std::int32_t y)
+		{
+			temporary(x, y) = field(x, y) + (field.Fetch(x + 1, y) + field.Fetch(x, y + 1)) * inverseBeta;
+		});
+
+		ForEachCell([&](const std::int32_t x, const std::int32_t y)
+		{
+			result(x, y) = temporary(x, y) + (temporary.Fetch(x - 1, y) + temporary.Fetch(x, y - 1)) * inverseBeta;
+		});
+	}
+
+private:
+	CStdThreadPool &threadPool;
+	CStdGrid<T> residual;
+	CStdGrid<T> preconditioned;
+	CStdGrid<T> direction;
+	CStdGrid<T> product;
+	CStdGrid<T> temporary;
+};
@@ -0,0 +1,106 @@
+"""Pre-build step of FluidSim2D: embeds every file of the shader directory into EmbeddedShaders.h.
+
+#include "name" directives are resolved against the same directory, a file is only inlined the first time it is included.
+#line directives keep the compiler messages pointing at the right lines of the including file.
+The header is only rewritten if its contents change, so unchanged shaders do not trigger a rebuild.
+
+Usage: python EmbedShaders.py <shader directory> <output header>
+"""
+
+import os
+import re
+import sys
+
+INCLUDE = re.compile(r'^\s*#\s*include\s+"([^"]+)"\s*$')
+# MSVC limits a single string literal to 16380 bytes, longer sources are split into adjacent literals
+CHUNK_SIZE = 8192
+DELIMITER = 'glsl'
+
+
+def resolve(name, files, included, stack):
+    if name not in files:
+        raise ValueError('{}: included file {} does not exist'.format(stack[-1] if stack else name, name))
+    if name in stack:
+        raise ValueError('Include cycle: {}'.format(' -> '.join(stack + [name])))
+
+    lines = []
+    for number, line in enumerate(files[name].split('\n'), 1):
+        match = INCLUDE.match(line)
+        if not match:
+            lines.append(line)
+            continue
+
+        include = match.group(1)
+        if include in included:
+            lines.append('')
+            continue
+
+        included.add(include)
+        lines.append('#line 1')
+        lines.extend(resolve(include, files, included, stack + [name]))
+        lines.append('#line {}'.format(number + 1))
+
+    return lines
+
+
+def literal(source):
+    if ')' + DELIMITER + '"' in source:
+        raise ValueError('Source contains the raw string delimiter')
+
+    chunks = [source[i:i + CHUNK_SIZE] for i in range(0, len(source), CHUNK_SIZE)] or ['']
+    return ' '.join('R"{0}({1}){0}"'.format(DELIMITER, chunk) for chunk in chunks)
+
+
+def main(directory, output):
+    files = {}
+    for name in sorted(os.listdir(directory)):
+        path = os.path.join(directory, name)
+        if os.path.isfile(path):
+            with open(path, encoding='utf-8', newline='') as file:
+                files[name] = file.read().replace('\r\n', '\n')
+
+    entries = []
+    for name in files:
+        source = '\n'.join(resolve(name, files, set(), []))
+        entries.append('\t\t{{"{}", {}}},'.format(name, literal(source)))
+
+    header = '\n'.join([
+        '// Generated by EmbedShaders.py from the files in Shader, do not edit',
+        '#pragma once',
+        '',
+        '#include <string_view>',
+        '',
+        'namespace EmbeddedShaders',
+        '{',
+        '\tstruct File',
+        '\t{',
+        '\t\tstd::string_view name;',
+        '\t\tstd::string_view source;',
+        '\t};',
+        '',
+        '\t// Sorted by name, with the #include directives resolved',
+        '\tinline constexpr File Files[]',
+        '\t{',
+    ] + entries + [
+        '\t};',
+        '}',
+        '',
+    ])
+
+    if os.path.exists(output):
+        with open(output, encoding='utf-8', newline='') as file:
+            if file.read() == header:
+                return
+
+    with open(output, 'w', encoding='utf-8', newline='') as file:
+        file.write(header)
+
+
+if __name__ == '__main__':
+    if len(sys.argv) != 3:
+        sys.exit(__doc__)
+
+    try:
+        main(sys.argv[1], sys.argv[2])
+    except (OSError, ValueError) as error:
+        sys.exit('EmbedShaders: {}'.format(error))
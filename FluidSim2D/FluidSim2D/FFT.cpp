@@ -0,0 +1,187 @@
+#include "FFT.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace
+{
+	constexpr double Pi{3.14159265358979323846};
+
+	// Plain product without the inf/nan recovery of operator*, which keeps the butterflies inlined
+	CStdFFT::Complex Multiply(const CStdFFT::Complex &a, const CStdFFT::Complex &b)
+	{
+		return {a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real()};
+	}
+
+	bool IsPowerOfTwo(const std::size_t value)
+	{
+		return value && !(value & (value - 1));
+	}
+}
+
+CStdFFT::CStdFFT(const std::size_t length)
+	: length{length}, paddedLength{1}, chirp(length)
+{
+	while (paddedLength < 2 * length - 1)
+	{
+		paddedLength <<= 1;
+	}
+
+	const std::size_t twiddleSize{IsPowerOfTwo(length) ? std::max(length, paddedLength) : paddedLength};
+	twiddles.resize(twiddleSize / 2);
+	for (std::size_t k{0}; k < twiddles.size(); ++k)
+	{
+		const double angle{-2.0 * Pi * k / twiddleSize};
+		twiddles[k] = Complex{static_cast<float>(std::cos(angle)), static_cast<float>(std::sin(angle))};
+	}
+
+	// n^2 is reduced modulo 2 * length first, the angle would lose all precision for large n otherwise
+	for (std::size_t n{0}; n < length; ++n)
+	{
+		const double angle{-Pi * static_cast<double>((n * n) % (2 * length)) / length};
+		chirp[n] = Complex{static_cast<float>(std::cos(angle)), static_cast<float>(std::sin(angle))};
+	}
+
+	chirpSpectrum.assign(paddedLength, Complex{});
+	chirpSpectrum[0] = std::conj(chirp[0]);
+	for (std::size_t n{1}; n < length; ++n)
+	{
+		chirpSpectrum[n] = chirpSpectrum[paddedLength - n] = std::conj(chirp[n]);
+	}
+
+	Radix2(chirpSpectrum.data(), paddedLength, false);
+}
+
+void CStdFFT::Transform(Complex *const data, const bool inverse, std::vector<Complex> &scratch) const
+{
+	// The inverse is the conjugate of the forward transform of the conjugate
+	if (inverse)
+	{
+		for (std::size_t i{0}; i < length; ++i)
+		{
+			data[i] = std::conj(data[i]);
+		}
+	}
+
+	if (IsPowerOfTwo(length))
+	{
+		Radix2(data, length, false);
+	}
+	else
+	{
+		Bluestein(data, scratch);
+	}
+
+	if (inverse)
+	{
+		const float scale{1.0f / length};
+		for (std::size_t i{0}; i < length; ++i)
+		{
+			data[i] = std::conj(data[i]) * scale;
+		}
+	}
+}
+
+// Unscaled in both directions
+void CStdFFT::Radix2(Complex *const data, const std::size_t size, const bool inverse) const
+{
+	for (std::size_t i{1}, j{0}; i < size; ++i)
+	{
+		std::size_t bit{size >> 1};
+		for (; j & bit; bit >>= 1)
+		{
+			j ^= bit;
+		}
+		j ^= bit;
+
+		if (i < j)
+		{
+			std::swap(data[i], data[j]);
+		}
+	}
+
+	for (std::size_t span{1}; span < size; span <<= 1)
+	{
+		const std::size_t twiddleStride{twiddles.size() / span};
+
+		for (std::size_t group{0}; group < size; group += 2 * span)
+		{
+			for (std::size_t offset{0}; offset < span; ++offset)
+			{
+				const Complex &twiddle{twiddles[offset * twiddleStride]};
+				Complex &even{data[group + offset]};
+				Complex &odd{data[group + offset + span]};
+				const Complex t{Multiply(inverse ? std::conj(twiddle) : twiddle, odd)};
+
+				odd = even - t;
+				even += t;
+			}
+		}
+	}
+}
+
+// X[k] = w[k] * sum_n (x[n] * w[n]) * conj(w[k - n]), the sum is a circular convolution of the padded sequences
+void CStdFFT::Bluestein(Complex *const data, std::vector<Complex> &scratch) const
+{
+	scratch.assign(paddedLength, Complex{});
+	for (std::size_t n{0}; n < length; ++n)
+	{
+		scratch[n] = Multiply(data[n], chirp[n]);
+	}
+
+	Radix2(scratch.data(), paddedLength, false);
+	for (std::size_t k{0}; k < paddedLength; ++k)
+	{
+		scratch[k] = Multiply(scratch[k], chirpSpectrum[k]);
+	}
+	Radix2(scratch.data(), paddedLength, true);
+
+	const float scale{1.0f / paddedLength};
+	for (std::size_t k{0}; k < length; ++k)
+	{
+		data[k] = Multiply(scratch[k], chirp[k]) * scale;
+	}
+}
+
+void CStdDHT::Forward(const float *const input, const std::ptrdiff_t inputStride, float *const output, const std::ptrdiff_t outputStride, const std::ptrdiff_t lineOffset, const std::size_t numLines, Workspace &workspace) const
+{
+	Transform(input, inputStride, output, outputStride, lineOffset, numLines, 1.0f, workspace);
+}
+
+void CStdDHT::Inverse(const float *const input, const std::ptrdiff_t inputStride, float *const output, const std::ptrdiff_t outputStride, const std::ptrdiff_t lineOffset, const std::size_t numLines, Workspace &workspace) const
+{
+	Transform(input, inputStride, output, outputStride, lineOffset, numLines, 1.0f / fft.GetLength(), workspace);
+}
+
+// H[k] = Re(X[k]) - Im(X[k]) for the FFT X of a real line.
+// Two real lines packed as z = x0 + i x1 are separated again with X0[k] = (Z[k] + conj(Z[N - k])) / 2 and X1[k] = (Z[k] - conj(Z[N - k])) / 2i.
+void CStdDHT::Transform(const float *const input, const std::ptrdiff_t inputStride, float *const output, const std::ptrdiff_t outputStride, const std::ptrdiff_t lineOffset, const std::size_t numLines, const float scale, Workspace &workspace) const
+{
+	const std::size_t length{fft.GetLength()};
+	const float *const second{numLines > 1 ? input + lineOffset : nullptr};
+	workspace.line.resize(length);
+
+	for (std::size_t n{0}; n < length; ++n)
+	{
+		const std::ptrdiff_t index{static_cast<std::ptrdiff_t>(n) * inputStride};
+		workspace.line[n] = Complex{input[index], second ? second[index] : 0.0f};
+	}
+
+	fft.Transform(workspace.line.data(), false, workspace.scratch);
+
+	for (std::size_t k{0}; k < length; ++k)
+	{
+		const Complex z{workspace.line[k]};
+		const Complex mirrored{std::conj(workspace.line[k ? length - k : 0])};
+		const std::ptrdiff_t index{static_cast<std::ptrdiff_t>(k) * outputStride};
+
+		const Complex first{0.5f * (z + mirrored)};
+		output[index] = scale * (first.real() - first.imag());
+		if (second)
+		{
+			const Complex other{Complex{0.0f, -0.5f} * (z - mirrored)};
+			output[index + lineOffset] = scale * (other.real() - other.imag());
+		}
+	}
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <complex>
+#include <cstddef>
+#include <vector>
+
+// Complex FFT of arbitrary length. Powers of two run an iterative radix-2 transform,
+// other lengths use Bluestein's algorithm on a zero padded power of two buffer.
+// The Bluestein tables are always built, the GL compute FFT uploads them as well.
+class CStdFFT
+{
+public:
+	using Complex = std::complex<float>;
+
+public:
+	explicit CStdFFT(std::size_t length);
+
+public:
+	// In place, the inverse includes the 1 / length scaling.
+	// scratch is resized as needed, every thread has to pass its own.
+	void Transform(Complex *data, bool inverse, std::vector<Complex> &scratch) const;
+
+	std::size_t GetLength() const { return length; }
+	std::size_t GetPaddedLength() const { return paddedLength; }
+
+	// w[n] = exp(-i pi n^2 / length) for n < length
+	const std::vector<Complex> &GetChirp() const { return chirp; }
+	// Forward transform of the padded conjugate chirp
+	const std::vector<Complex> &GetChirpSpectrum() const { return chirpSpectrum; }
+
+private:
+	void Radix2(Complex *data, std::size_t size, bool inverse) const;
+	void Bluestein(Complex *data, std::vector<Complex> &scratch) const;
+
+private:
+	std::size_t length;
+	std::size_t paddedLength;
+	std::vector<Complex> chirp;
+	std::vector<Complex> chirpSpectrum;
+	// exp(-2 pi i k / size) of the largest radix-2 size in use, smaller sizes take every n-th entry
+	std::vector<Complex> twiddles;
+};
+
+// Discrete Hartley transform H[k] = sum_n x[n] * (cos(2 pi k n / length) + sin(2 pi k n / length)) through one complex FFT of the same length.
+// Its basis functions are eigenvectors of the periodic 5-point Laplacian, and applied twice it gives the input back times length.
+// Both directions can take two lines at once, packed into the real and imaginary part of the same FFT.
+class CStdDHT
+{
+public:
+	using Complex = CStdFFT::Complex;
+
+	struct Workspace
+	{
+		std::vector<Complex> line;
+		std::vector<Complex> scratch;
+	};
+
+public:
+	explicit CStdDHT(std::size_t length) : fft{length} {}
+
+public:
+	// Strides are in elements, with numLines == 2 the second line starts lineOffset elements after the first
+	void Forward(const float *input, std::ptrdiff_t inputStride, float *output, std::ptrdiff_t outputStride, std::ptrdiff_t lineOffset, std::size_t numLines, Workspace &workspace) const;
+	// Exact inverse of Forward, the same transform scaled by 1 / length
+	void Inverse(const float *input, std::ptrdiff_t inputStride, float *output, std::ptrdiff_t outputStride, std::ptrdiff_t lineOffset, std::size_t numLines, Workspace &workspace) const;
+
+	const CStdFFT &GetFFT() const { return fft; }
+
+private:
+	void Transform(const float *input, std::ptrdiff_t inputStride, float *output, std::ptrdiff_t outputStride, std::ptrdiff_t lineOffset, std::size_t numLines, float scale, Workspace &workspace) const;
+
+private:
+	CStdFFT fft;
+};
@@ -18,9 +18,14 @@
 #include <unordered_map>
 
 #include "FPSLimiter.h"
+#include "GLFluidSolver.h"
+#include "Headless.h"
 #include "ImpulseState.h"
+#include "ProgramBinaryCache.h"
 #include "Shader.h"
+#include "StencilBenchmark.h"
 
+#ifdef _WIN32
 #define NOMINMAX
 #include <Windows.h>
 
@@ -28,135 +33,73 @@ extern "C"
 {
 	__declspec(dllexport) DWORD NvOptimusEnablement = 0x00000001;
 }
+#endif
 
 // Settings
 const unsigned int SCR_WIDTH = 800;
 const unsigned int SCR_HEIGHT = 800;
-// All bits except for last (even from odd)
-constexpr std::size_t NumJacobiRounds{30 & ~0x1};
 
 // Identifiers
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 
-static std::string LoadShader(std::string_view name)
-{
-    std::ifstream file;
-	file.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-	file.open(name.data());
-
-    return {std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
-};
-
 static void APIENTRY DebugMessageCallback(const GLenum source, const GLenum type, const GLuint id, const GLenum severity, const GLsizei length, const GLchar *const message, const void *const userParam)
 {
     std::ostringstream msg;
     msg << "source: " << source << ", type: " << type << ", id: " << id << ", severity: " << severity << ", message: " << std::string{ reinterpret_cast<const char* const>(message), static_cast<std::size_t>(length) } << "\n";
+#ifdef _WIN32
 	OutputDebugStringA(msg.str().c_str());
+#else
+	std::cerr << msg.str();
+#endif
 }
 
-class CStdLine : public CStdVAOObject<CStdLine>
-{
-public:
-    static constexpr inline auto Dimensions = 3;
-    static constexpr inline auto PrimitiveType = GL_LINES;
-
-public:
-	CStdLine(const glm::vec2 &start, const glm::vec2 &end) : CStdVAOObject{}, start{start}, end{end} { Init(); }
-
-protected:
-	virtual void GenerateGeometry(std::vector<GLfloat> &vertices, std::vector<GLuint> &elements, std::vector<GLfloat> &normals, std::vector<GLfloat> &textureCoordinates) override
-	{
-        vertices = {start.x, start.y, 0, end.x, end.y, 0};
-        elements = {0, 1};
-    }
-
-private:
-    glm::vec2 start;
-    glm::vec2 end;
-};
-
 class MainProgram
 {
-    struct Border
-    {
-        CStdLine top;
-        CStdLine left;
-        CStdLine bottom;
-        CStdLine right;
-    };
-
 public:
-    MainProgram(GLFWwindow *const window, const std::int32_t width, const int32_t height) 
+    MainProgram(GLFWwindow *const window, const std::int32_t width, const int32_t height, const Variables &vars) 
         : window{window},
           width{width},
           height{height},
           gridScale{1.0f / width, 1.0f / height},
-          velocityBuffer{width, height},
-          pressureBuffer{width, height},
-          vorticityBuffer{width, height},
-          temporaryBuffer{width, height},
-          border{InitBorder()},
+          vars{vars},
+          solver{vars, width, height},
 		  limiter{FPS}
 	{
 		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
     }
 
 public:
-    void CopyBuffers(const CStdFramebuffer &source, const CStdFramebuffer &destination);
     void DrawQuad();
     void Load2DShaders();
     void Run();
     void ProcessInput();
     void DoDroplets();
-    void SetBounds(float scale);
 
 private:
-    Border InitBorder();
-    void BindTexture(CStdGLShaderProgram &program, const std::string &key, const CStdTexture &texture, GLuint offset);
-    void SolvePoissonSystem(CStdSwappableFramebuffer &swappableBuffer, const CStdFramebuffer &initialValue, float alpha, float beta);
     glm::vec2 RandomPosition() const;
-    void ResizeFramebuffer(CStdFramebuffer &frameBuffer, std::int32_t newWidth, std::int32_t newHeight);
-    void ResizeFramebuffer(CStdSwappableFramebuffer &swappableBuffer, std::int32_t newWidth, std::int32_t newHeight);
+    void ReportStatistics();
+    void ReportFieldMemory() const;
+    bool PollShaders();
 
 private:
-    CStdGLShaderProgram advectShaderProgram;
-    CStdGLShaderProgram addImpulseShaderProgram;
-	CStdGLShaderProgram addRadialImpulseShaderProgram;
-    CStdGLShaderProgram vorticityShaderProgram;
-    CStdGLShaderProgram addVorticityShaderProgram;
-    CStdGLShaderProgram jacobiShaderProgram;
-    CStdGLShaderProgram divergenceShaderProgram;
-    CStdGLShaderProgram gradientShaderProgram;
-    CStdGLShaderProgram subtractShaderProgram;
-    CStdGLShaderProgram boundaryShaderProgram;
-    CStdGLShaderProgram copyShaderProgram;
     CStdGLShaderProgram renderShaderProgram;
 
     GLFWwindow *window;
     int32_t width;
     int32_t height;
     glm::vec2 gridScale;
+    Variables vars;
     CStdRectangle quad;
-    CStdSwappableFramebuffer velocityBuffer;
-    CStdSwappableFramebuffer pressureBuffer;
-    CStdFramebuffer vorticityBuffer;
-    CStdFramebuffer temporaryBuffer;
-    Border border;
+    CStdGLFluidSolver solver;
     float dt;
     ImpulseState impulseState;
+    // The pool of transient targets is only filled by a Step, so the report waits for the next one
+    bool reportPending{true};
+    bool shadersReady{false};
     static constexpr inline int FPS{ 60 };
     FPSLimiter limiter;
 };
 
-// Copies frameBuffer from source to destination
-void MainProgram::CopyBuffers(const CStdFramebuffer &source, const CStdFramebuffer &destination)
-{
-    destination.Bind();
-    copyShaderProgram.Select();
-	BindTexture(copyShaderProgram, "field", source.GetTexture(), 0);
-    DrawQuad();
-}
-
 void MainProgram::DrawQuad()
 {
     quad.Bind();
@@ -165,57 +108,41 @@ void MainProgram::DrawQuad()
 
 void MainProgram::Load2DShaders()
 {
-	CStdGLShader texCoordsShader{CStdShader::Type::Vertex, LoadShader("../Shader/tex_coords.vert")};
-	texCoordsShader.Compile();
+    solver.LoadShaders();
 
-	const auto newShader = [this, &texCoordsShader](CStdGLShaderProgram &shaderProgram, std::string_view objectLabel)
-	{
-		CStdGLShader shader{CStdShader::Type::Fragment, LoadShader(std::string{"../Shader/"} + objectLabel.data() + ".frag")};
-		shader.Compile();
-
-		shaderProgram.AddShader(&texCoordsShader);
-		shaderProgram.AddShader(&shader);
-		shaderProgram.Link();
-		shaderProgram.SetObjectLabel(objectLabel);
-
-		glm::vec2 s{gridScale};
-		shaderProgram.Select();
-		shaderProgram.SetUniform("stride", gridScale);
-	};
-
-	newShader(advectShaderProgram, "advection");
-	newShader(addImpulseShaderProgram, "add_impulse");
-	newShader(addRadialImpulseShaderProgram, "add_radial_impulse");
-	newShader(vorticityShaderProgram, "vorticity");
-	newShader(addVorticityShaderProgram, "add_vorticity");
-	newShader(jacobiShaderProgram, "jacobi");
-	newShader(divergenceShaderProgram, "divergence");
-	newShader(gradientShaderProgram, "gradient");
-	newShader(subtractShaderProgram, "subtract");
-	newShader(boundaryShaderProgram, "boundary");
-	newShader(copyShaderProgram, "copy");
-
-    CStdGLShader vertexShader{ CStdShader::Type::Vertex, LoadShader("../Shader/vertexShader.glsl") };
+    CStdGLShader vertexShader{ CStdShader::Type::Vertex, LoadShader("vertexShader.glsl") };
     vertexShader.Compile();
 
-    CStdGLShader fragmentShader{ CStdShader::Type::Fragment, LoadShader("../Shader/fragmentShader.glsl") };
+    CStdGLShader fragmentShader{ CStdShader::Type::Fragment, LoadShader("fragmentShader.glsl") };
+    fragmentShader.AddExtension(CStdGLFluidSolver::SamplerBindingExtension);
     fragmentShader.Compile();
 
     renderShaderProgram.AddShader(&vertexShader);
     renderShaderProgram.AddShader(&fragmentShader);
-    renderShaderProgram.Link();
+    renderShaderProgram.BeginLink();
 	renderShaderProgram.SetObjectLabel("render");
 }
 
-constexpr struct Variables
+// Finishes the programs once the driver is done with all of them, Run shows an empty frame until then
+bool MainProgram::PollShaders()
 {
-    float advectionDissipation;
-    float gridScale;
-    float vorticity;
-    float viscosity;
-    float splatRadius;
-    bool droplets;
-} vars{0.99f, 0.3f, 0.005f, 0.001f, 0.003f, false};
+    if (!solver.AreShadersReady() || !renderShaderProgram.IsLinkComplete())
+    {
+        return false;
+    }
+
+    solver.FinishLoadingShaders();
+    renderShaderProgram.FinishLink();
+
+    std::cout << "Shaders ready after " << static_cast<long>(glfwGetTime() * 1000.0) << " ms";
+    if (const CStdProgramBinaryCache *const cache{CStdGLShaderProgram::GetBinaryCache()})
+    {
+        std::cout << ", " << cache->GetCounters().loaded << " programs loaded from the binary cache, " << cache->GetCounters().compiled << " compiled";
+    }
+    std::cout << "\n";
+
+    return true;
+}
 
 void MainProgram::Run()
 {
@@ -231,6 +158,16 @@ void MainProgram::Run()
         dt = lastTime == 0 ? 0.016667 : (now - lastTime) - timeStepEventPoll;
         lastTime = now;
 
+        CStdGLState::ResetCounters();
+
+        if (!shadersReady && !(shadersReady = PollShaders()))
+        {
+            glClear(GL_COLOR_BUFFER_BIT);
+            limiter.Regulate();
+            glfwSwapBuffers(window);
+            continue;
+        }
+
         ProcessInput();
 
 		if (vars.droplets)
@@ -238,125 +175,29 @@ void MainProgram::Run()
             DoDroplets();
 		}
 
-		glViewport(0, 0, width, height);
-
-#pragma region Advection
-        SetBounds(-1);
-
-        velocityBuffer.GetBack().Bind();
-        advectShaderProgram.Select();
-        advectShaderProgram.SetUniform("dissipation", glUniform1f, vars.advectionDissipation);
-        BindTexture(advectShaderProgram, "quantity", velocityBuffer.GetFront().GetTexture(), 1);
-        advectShaderProgram.SetUniform("gs", glUniform1f, vars.gridScale);
-        advectShaderProgram.SetUniform("rdv", gridScale);
-        advectShaderProgram.SetUniform("delta_t", dt);
-        BindTexture(advectShaderProgram, "velocity", velocityBuffer.GetFront().GetTexture(), 0);
-        DrawQuad();
-
-		velocityBuffer.SwapBuffers();
-#pragma endregion
+        solver.Step(dt, impulseState);
 
-#pragma region Force Application
-		if (impulseState.IsActive())
+        if (reportPending)
         {
-            const auto diff = impulseState.Delta;
-			const glm::vec3 force{ std::clamp(diff.x, -vars.gridScale, vars.gridScale), std::clamp(diff.y, -vars.gridScale, vars.gridScale), 0 };
-			/*const glm::vec3 force(std::min(std::max(diff.x, -vars.gridScale), vars.gridScale),
-						std::min(std::max(diff.y, -vars.gridScale), vars.gridScale),
-						0);*/
-
-            velocityBuffer.GetBack().Bind();
-
-			CStdGLShaderProgram &program{impulseState.Radial ? addRadialImpulseShaderProgram : addImpulseShaderProgram};
-
-			program.Select();
-			program.SetUniform("position", glm::vec2{ impulseState.CurrentPos.x, impulseState.CurrentPos.y } * gridScale);
-			program.SetUniform("radius", vars.splatRadius);
-			BindTexture(program, "velocity", velocityBuffer.GetFront().GetTexture(), 0);
-
-			if (!impulseState.Radial)
-			{
-				program.SetUniform("force", force);
-			}
-
-			program.SetUniform("delta_t", dt);
-
-            DrawQuad();
-
-            velocityBuffer.SwapBuffers();
-		}
-#pragma endregion
-
-#pragma region Vorticity
-        vorticityBuffer.Bind();
-        vorticityShaderProgram.Select();
-        vorticityShaderProgram.SetUniform("gs", glUniform1f, vars.gridScale);
-        BindTexture(vorticityShaderProgram, "velocity", velocityBuffer.GetFront().GetTexture(), 0);
-        DrawQuad();
-#pragma endregion
-
-        SetBounds(-1);
-
-#pragma region Add Vorticity
-        velocityBuffer.GetBack().Bind();
-        addVorticityShaderProgram.Select();
-        addVorticityShaderProgram.SetUniform("gs", glUniform1f, vars.gridScale);
-        BindTexture(addVorticityShaderProgram, "velocity", velocityBuffer.GetFront().GetTexture(), 0);
-        BindTexture(addVorticityShaderProgram, "vorticity", vorticityBuffer.GetTexture(), 1);
-		addVorticityShaderProgram.SetUniform("delta_t", glUniform1f, 1.0f);
-        addVorticityShaderProgram.SetUniform("scale", vars.vorticity);
-        DrawQuad();
-		velocityBuffer.SwapBuffers();
-#pragma endregion
-
-#pragma region Diffusion
-        const float alpha{(vars.gridScale * vars.gridScale) / (vars.viscosity * dt)};
-        const float beta{alpha + 4.0f};
-        SolvePoissonSystem(velocityBuffer, velocityBuffer.GetFront(), alpha, beta);
-#pragma endregion
-
-#pragma region Projection
-        // Calculate div(W)
-        velocityBuffer.GetBack().Bind();
-        divergenceShaderProgram.Select();
-        divergenceShaderProgram.SetUniform("gs", glUniform1f, vars.gridScale);
-        BindTexture(divergenceShaderProgram, "field", velocityBuffer.GetFront().GetTexture(), 0);
-        DrawQuad();
-		
-        // Solve for P in: Laplacian(P) = div(W)
-        SolvePoissonSystem(pressureBuffer, velocityBuffer.GetBack(), -vars.gridScale * vars.gridScale, 4.0f);
-		
-		// Calculate grad(P)
-        pressureBuffer.GetBack().Bind();
-        gradientShaderProgram.Select();
-        gradientShaderProgram.SetUniform("gs", glUniform1f, vars.gridScale);
-        BindTexture(gradientShaderProgram, "field", pressureBuffer.GetFront().GetTexture(), 0);
-        DrawQuad();
-		// No swap, back buffer has the gradient
-        
-        // Calculate U = W - grad(P) where div(U)=0
-        velocityBuffer.GetBack().Bind();
-        subtractShaderProgram.Select();
-        BindTexture(subtractShaderProgram, "a", velocityBuffer.GetFront().GetTexture(), 0);
-        BindTexture(subtractShaderProgram, "b", pressureBuffer.GetBack().GetTexture(), 1);
-        DrawQuad();
-        velocityBuffer.SwapBuffers();
-
-        SetBounds(-1);
-		
-            
-#pragma endregion
-
+            ReportFieldMemory();
+            reportPending = false;
+        }
 
 #pragma region Rendering
-        velocityBuffer.Unbind();
-		glViewport(0, 0, width, height);
+        solver.GetVelocityBuffer().Unbind();
+		CStdGLState::Viewport(0, 0, width, height);
 		glClear(GL_COLOR_BUFFER_BIT);
         renderShaderProgram.Select();
-        BindTexture(renderShaderProgram, "field", velocityBuffer.GetFront().GetTexture(), 0);
+        CStdGLFluidSolver::BindTexture(renderShaderProgram, "field", solver.GetVelocityBuffer().GetTexture());
+        renderShaderProgram.SetUniform("obstacles", glUniform1i, solver.GetObstacleField() != nullptr);
+        if (const CStdFramebuffer *const obstacleField{solver.GetObstacleField()})
+        {
+            CStdGLFluidSolver::BindTexture(renderShaderProgram, "obstacleField", obstacleField->GetTexture());
+        }
         DrawQuad();
 #pragma endregion
 
+        ReportStatistics();
         limiter.Regulate();
 
         glfwSwapBuffers(window);
@@ -386,13 +227,56 @@ void MainProgram::ProcessInput()
 
         gridScale = glm::vec2{1.0f / width, 1.0f / height};
 
-        ResizeFramebuffer(velocityBuffer, width, height);
-        ResizeFramebuffer(pressureBuffer, width, height);
-        ResizeFramebuffer(vorticityBuffer, width, height);
-        ResizeFramebuffer(temporaryBuffer, width, height);
+        solver.Resize(width, height);
+        reportPending = true;
     }
 }
 
+// Shows the iterations and final relative residual of the last finished diffusion and pressure solves in the title bar,
+// along with the binds of this frame that reached the driver and those CStdGLState dropped
+void MainProgram::ReportStatistics()
+{
+    const auto format = [](std::ostringstream &title, const char *const name, const PoissonStatistics &statistics)
+    {
+        title << name << ": " << statistics.iterations << " it";
+        if (statistics.residual >= 0.0f)
+        {
+            title << ", r " << std::scientific << std::setprecision(1) << statistics.residual << std::defaultfloat;
+        }
+    };
+
+    std::ostringstream title;
+    title << "FluidSim2D - ";
+    format(title, "diffusion", solver.GetPoissonStatistics(PoissonSystem::Diffusion));
+    title << " | ";
+    format(title, "pressure", solver.GetPoissonStatistics(PoissonSystem::Pressure));
+    title << " | " << solver.GetPassCount() << " passes";
+
+    const CStdGLState::Counters &binds{CStdGLState::GetCounters()};
+    title << " | binds: " << binds.issued << " issued, " << binds.filtered << " filtered";
+
+    glfwSetWindowTitle(window, title.str().c_str());
+}
+
+// Prints the storage of the simulation fields in their configured formats and the frame graph of the last Step, bandwidth is per full-field read or write
+void MainProgram::ReportFieldMemory() const
+{
+    static constexpr double MiB{1024.0 * 1024.0};
+
+    std::size_t total{0};
+    std::cout << "Fields at " << width << "x" << height << ":\n" << std::fixed << std::setprecision(2);
+    for (const CStdGLFluidSolver::FieldMemory &field : solver.GetFieldMemory())
+    {
+        std::cout << "  " << std::left << std::setw(10) << field.name << std::setw(6) << CStdGLFluidSolver::GetFieldFormatInfo(field.format).name << std::right
+            << " x" << field.buffers << ": " << field.bytes / MiB << " MiB, " << field.bytesPerPass / MiB << " MiB per pass\n";
+        total += field.bytes;
+    }
+
+    std::cout << "  total: " << total / MiB << " MiB" << std::defaultfloat << "\n";
+    solver.GetFrameGraph().PrintSchedule(std::cout);
+    std::cout << std::flush;
+}
+
 void MainProgram::DoDroplets()
 {
     static float acc{ 0.0f };
@@ -423,78 +307,25 @@ void MainProgram::DoDroplets()
     }
 }
 
-void MainProgram::SetBounds(const float scale)
+int main(int argc, char *argv[])
 {
-    CopyBuffers(velocityBuffer.GetFront(), velocityBuffer.GetBack());
-    boundaryShaderProgram.Select();
-    boundaryShaderProgram.SetUniform("rdv", gridScale);
-	BindTexture(boundaryShaderProgram, "field", velocityBuffer.GetFront().GetTexture(), 0);
-    boundaryShaderProgram.SetUniform("scale", glUniform1f, scale);
-
-    velocityBuffer.GetBack().Bind();
-
-    static constexpr glm::vec2 Top{0, -1};
-    static constexpr glm::vec2 Left{1, 0};
-    static constexpr glm::vec2 Bottom{0, 1};
-    static constexpr glm::vec2 Right{-1, 0};
-
-    boundaryShaderProgram.SetUniform("offset", Top);
-    border.top.Bind();
-    border.top.Draw();
-
-    boundaryShaderProgram.SetUniform("offset", Left);
-    border.left.Bind();
-    border.left.Draw();
-
-    boundaryShaderProgram.SetUniform("offset", Bottom);
-    border.bottom.Bind();
-    border.bottom.Draw();
-
-    boundaryShaderProgram.SetUniform("offset", Right);
-    border.right.Bind();
-    border.right.Draw();
-
-    velocityBuffer.SwapBuffers();
-}
-
-auto MainProgram::InitBorder() -> Border
-{
-    const glm::vec2 c{1.0f - 0.5f / width, 1.0f - 0.5f / height};
-
-    return Border
+    for (int i{1}; i + 1 < argc; ++i)
     {
-        {{-c.x, -c.y}, { c.x, -c.y}},
-        {{-c.x,  c.y}, {-c.x, -c.y}},
-        {{ c.x,  c.y}, {-c.x,  c.y}},
-		{{ c.x, -c.y}, { c.x,  c.y}}
-    };
-}
-
-void MainProgram::BindTexture(CStdGLShaderProgram &program, const std::string &key, const CStdTexture &texture, GLuint offset)
-{
-    program.SetUniform(key, glUniform1i, offset);
-    texture.Bind(offset);
-}
-
-void MainProgram::SolvePoissonSystem(CStdSwappableFramebuffer &swappableBuffer, const CStdFramebuffer &initialValue, float alpha, float beta)
-{
-    CopyBuffers(initialValue, temporaryBuffer);
-    jacobiShaderProgram.Select();
-    jacobiShaderProgram.SetUniform("alpha", glUniform1f, alpha);
-    jacobiShaderProgram.SetUniform("beta", glUniform1f, beta);
-    BindTexture(jacobiShaderProgram, "b", temporaryBuffer.GetTexture(), 1);
+        // Reads the shaders from disk instead of the copies built into the executable, e.g. --shader-dir ../Shader
+        if (std::string_view{argv[i]} == "--shader-dir")
+        {
+            SetShaderDirectory(argv[i + 1]);
+        }
+    }
 
-    for (std::size_t i{0}; i < NumJacobiRounds; ++i)
+    for (int i{1}; i < argc; ++i)
     {
-        swappableBuffer.GetBack().Bind();
-        BindTexture(jacobiShaderProgram, "x", swappableBuffer.GetFront().GetTexture(), 0);
-        DrawQuad();
-        swappableBuffer.SwapBuffers();
+        if (std::string_view{argv[i]} == "--headless")
+        {
+            return RunHeadless(argc, argv);
+        }
     }
-}
 
-int main()
-{
     // GLFW init and config
     // ---------------------------------
     struct GLFW { GLFW() { glfwInit(); } ~GLFW() { glfwTerminate(); }} glfw;
@@ -535,7 +366,28 @@ int main()
     glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
     glDebugMessageCallback(DebugMessageCallback, nullptr);
 
-	MainProgram mainProgram{window, SCR_WIDTH + 2, SCR_HEIGHT + 2};
+    for (int i{1}; i < argc; ++i)
+    {
+        if (std::string_view{argv[i]} == "--benchmark-stencils")
+        {
+            return RunStencilBenchmark(argc, argv, SCR_WIDTH + 2, SCR_HEIGHT + 2);
+        }
+
+        if (std::string_view{argv[i]} == "--check-jacobi-blocking")
+        {
+            return RunJacobiBlockingCheck(argc, argv, SCR_WIDTH + 2, SCR_HEIGHT + 2);
+        }
+    }
+
+    Variables vars;
+    ParseVariables(argc, argv, vars, {{"--shader-dir", true}});
+
+    // Warm starts link every program from the binaries of the previous run
+    CStdProgramBinaryCache programCache{"ShaderCache"};
+    CStdGLShaderProgram::SetBinaryCache(&programCache);
+    CStdGLShaderProgram::EnableParallelCompile();
+
+	MainProgram mainProgram{window, SCR_WIDTH + 2, SCR_HEIGHT + 2, vars};
     mainProgram.Load2DShaders();
     mainProgram.Run();
 
@@ -548,30 +400,10 @@ glm::vec2 MainProgram::RandomPosition() const
     return { std::rand() % width, std::rand() % height };
 }
 
-void MainProgram::ResizeFramebuffer(CStdFramebuffer &frameBuffer, std::int32_t newWidth, std::int32_t newHeight)
-{
-    CStdFramebuffer newFrameBuffer{newWidth, newHeight};
-
-    CopyBuffers(frameBuffer, newFrameBuffer);
-    frameBuffer = std::move(newFrameBuffer);
-}
-
-void MainProgram::ResizeFramebuffer(CStdSwappableFramebuffer &swappableBuffer, std::int32_t newWidth, std::int32_t newHeight)
-{
-    CStdSwappableFramebuffer newSwappableBuffer{newWidth, newHeight};
-
-    CopyBuffers(swappableBuffer.GetFront(), newSwappableBuffer.GetFront());
-    CopyBuffers(swappableBuffer.GetBack(), newSwappableBuffer.GetBack());
-
-    swappableBuffer = std::move(newSwappableBuffer);
-
-    newWidth;
-}
-
 // GLFW - Window size change callback function
 void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 {
-    glViewport(0, 0, width, height);
+    CStdGLState::Viewport(0, 0, width, height);
 }
 
 // GLFW - Input handler
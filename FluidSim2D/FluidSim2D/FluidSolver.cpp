@@ -0,0 +1,413 @@
+#include "FluidSolver.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace
+{
+	BoundaryCondition ParseBoundaryCondition(const std::string_view value)
+	{
+		if (value == "no-slip")
+		{
+			return BoundaryCondition::NoSlip;
+		}
+		else if (value == "free-slip")
+		{
+			return BoundaryCondition::FreeSlip;
+		}
+		else if (value == "inflow")
+		{
+			return BoundaryCondition::Inflow;
+		}
+		else if (value == "outflow")
+		{
+			return BoundaryCondition::Outflow;
+		}
+		else if (value == "periodic")
+		{
+			return BoundaryCondition::Periodic;
+		}
+
+		throw std::invalid_argument{"Unknown boundary condition: " + std::string{value}};
+	}
+
+	glm::vec2 ParseVector(const std::string_view value)
+	{
+		const std::size_t comma{value.find(',')};
+		if (comma == std::string_view::npos)
+		{
+			throw std::invalid_argument{"Expected <x>,<y>: " + std::string{value}};
+		}
+
+		return glm::vec2{std::stof(std::string{value.substr(0, comma)}), std::stof(std::string{value.substr(comma + 1)})};
+	}
+
+	FieldFormat ParseFieldFormat(const std::string_view value)
+	{
+		if (value == "r16f")
+		{
+			return FieldFormat::R16F;
+		}
+		else if (value == "r32f")
+		{
+			return FieldFormat::R32F;
+		}
+		else if (value == "rg16f")
+		{
+			return FieldFormat::RG16F;
+		}
+		else if (value == "rg32f")
+		{
+			return FieldFormat::RG32F;
+		}
+
+		throw std::invalid_argument{"Unknown field format: " + std::string{value}};
+	}
+
+	bool IsPeriodic(const Variables &vars, const BoundarySide side)
+	{
+		return vars.boundaries[static_cast<std::size_t>(side)] == BoundaryCondition::Periodic;
+	}
+}
+
+void ParseVariables(const int argc, char *argv[], Variables &vars, const std::initializer_list<ProgramOption> programOptions)
+{
+	for (int i{1}; i < argc; ++i)
+	{
+		const std::string_view arg{argv[i]};
+
+		const auto programOption = std::find_if(programOptions.begin(), programOptions.end(), [arg](const ProgramOption &option) { return option.name == arg; });
+		if (programOption != programOptions.end())
+		{
+			i += programOption->takesValue;
+			continue;
+		}
+
+		// Every option of the variables takes a value
+		if (i + 1 == argc)
+		{
+			throw std::invalid_argument{"Unknown option or missing value: " + std::string{arg}};
+		}
+
+		const std::string_view value{argv[i + 1]};
+
+		if (arg == "--backend")
+		{
+			if (value == "fragment")
+			{
+				vars.backend = SimulationBackend::Fragment;
+			}
+			else if (value == "compute")
+			{
+				vars.backend = SimulationBackend::Compute;
+			}
+			else
+			{
+				throw std::invalid_argument{"Unknown backend: " + std::string{value}};
+			}
+		}
+		else if (arg == "--fuse")
+		{
+			const bool all{value == "all"};
+			vars.fusedPasses = FusedPasses{all, all, all, all};
+
+			for (std::size_t begin{0}; !all && value != "none" && begin <= value.size();)
+			{
+				const std::size_t end{std::min(value.find(',', begin), value.size())};
+				const std::string_view pass{value.substr(begin, end - begin)};
+				begin = end + 1;
+
+				if (pass == "vorticity")
+				{
+					vars.fusedPasses.vorticity = true;
+				}
+				else if (pass == "gradient-subtract")
+				{
+					vars.fusedPasses.gradientSubtract = true;
+				}
+				else if (pass == "divergence")
+				{
+					vars.fusedPasses.divergence = true;
+				}
+				else if (pass == "copies")
+				{
+					vars.fusedPasses.copies = true;
+				}
+				else
+				{
+					throw std::invalid_argument{"Unknown fused pass: " + std::string{pass}};
+				}
+			}
+		}
+		else if (arg == "--boundary")
+		{
+			if (value.find(',') == std::string_view::npos)
+			{
+				vars.boundaries.fill(ParseBoundaryCondition(value));
+			}
+			else
+			{
+				std::size_t side{0};
+				for (std::size_t begin{0}; begin <= value.size(); ++side)
+				{
+					const std::size_t end{std::min(value.find(',', begin), value.size())};
+					if (side == vars.boundaries.size())
+					{
+						throw std::invalid_argument{"Too many boundary conditions: " + std::string{value}};
+					}
+
+					vars.boundaries[side] = ParseBoundaryCondition(value.substr(begin, end - begin));
+					begin = end + 1;
+				}
+
+				if (side != vars.boundaries.size())
+				{
+					throw std::invalid_argument{"Expected four boundary conditions: " + std::string{value}};
+				}
+			}
+		}
+		else if (arg == "--inflow-velocity")
+		{
+			vars.inflowVelocity = ParseVector(value);
+		}
+		else if (arg == "--obstacles")
+		{
+			vars.obstacleMask = value;
+		}
+		else if (arg == "--obstacle-velocity")
+		{
+			vars.obstacleVelocity = ParseVector(value);
+		}
+		else if (arg == "--velocity-format")
+		{
+			vars.fieldFormats.velocity = ParseFieldFormat(value);
+			if (vars.fieldFormats.velocity != FieldFormat::RG16F && vars.fieldFormats.velocity != FieldFormat::RG32F)
+			{
+				throw std::invalid_argument{"The velocity needs a two channel format: " + std::string{value}};
+			}
+		}
+		else if (arg == "--pressure-format")
+		{
+			vars.fieldFormats.pressure = ParseFieldFormat(value);
+		}
+		else if (arg == "--vorticity-format")
+		{
+			vars.fieldFormats.vorticity = ParseFieldFormat(value);
+		}
+		else if (arg == "--stencil-fetch")
+		{
+			if (value == "auto")
+			{
+				vars.stencilFetch = StencilFetch::Auto;
+			}
+			else if (value == "filtered")
+			{
+				vars.stencilFetch = StencilFetch::Filtered;
+			}
+			else if (value == "texel-fetch")
+			{
+				vars.stencilFetch = StencilFetch::TexelFetch;
+			}
+			else if (value == "gather")
+			{
+				vars.stencilFetch = StencilFetch::Gather;
+			}
+			else
+			{
+				throw std::invalid_argument{"Unknown stencil fetch: " + std::string{value}};
+			}
+		}
+		else if (arg == "--poisson-solver")
+		{
+			if (value == "jacobi")
+			{
+				vars.poissonSolver = PoissonSolver::Jacobi;
+			}
+			else if (value == "chebyshev")
+			{
+				vars.poissonSolver = PoissonSolver::Chebyshev;
+			}
+			else if (value == "multigrid")
+			{
+				vars.poissonSolver = PoissonSolver::Multigrid;
+			}
+			else if (value == "sor")
+			{
+				vars.poissonSolver = PoissonSolver::RedBlackSOR;
+			}
+			else if (value == "pcg")
+			{
+				vars.poissonSolver = PoissonSolver::ConjugateGradient;
+			}
+			else
+			{
+				throw std::invalid_argument{"Unknown poisson solver: " + std::string{value}};
+			}
+		}
+		else if (arg == "--poisson-max-iterations")
+		{
+			vars.poissonMaxIterations = std::stoul(argv[i + 1]);
+		}
+		else if (arg == "--poisson-tolerance")
+		{
+			vars.poissonTolerance = std::stof(argv[i + 1]);
+		}
+		else if (arg == "--poisson-check-interval")
+		{
+			vars.poissonCheckInterval = std::max<std::size_t>(std::stoul(argv[i + 1]), 1);
+		}
+		else if (arg == "--jacobi-block-sweeps")
+		{
+			vars.jacobiBlockSweeps = std::stoul(argv[i + 1]);
+			if (vars.jacobiBlockSweeps < 1 || vars.jacobiBlockSweeps > 8)
+			{
+				throw std::invalid_argument{"Jacobi block sweeps out of range: " + std::string{value}};
+			}
+		}
+		else if (arg == "--projection")
+		{
+			if (value == "iterative")
+			{
+				vars.projection = ProjectionMethod::Iterative;
+			}
+			else if (value == "spectral")
+			{
+				vars.projection = ProjectionMethod::Spectral;
+			}
+			else
+			{
+				throw std::invalid_argument{"Unknown projection method: " + std::string{value}};
+			}
+		}
+		else if (arg == "--multigrid-cycle")
+		{
+			if (value == "v")
+			{
+				vars.multigridCycle = MultigridCycle::V;
+			}
+			else if (value == "f")
+			{
+				vars.multigridCycle = MultigridCycle::F;
+			}
+			else
+			{
+				throw std::invalid_argument{"Unknown multigrid cycle: " + std::string{value}};
+			}
+		}
+		else if (arg == "--multigrid-cycles")
+		{
+			vars.multigridCycles = std::stoul(argv[i + 1]);
+		}
+		else if (arg == "--multigrid-smoothing")
+		{
+			vars.multigridSmoothingSteps = std::stoul(argv[i + 1]);
+		}
+		else if (arg == "--sor-iterations")
+		{
+			vars.sorIterations = std::stoul(argv[i + 1]);
+		}
+		else if (arg == "--sor-omega")
+		{
+			vars.sorOmega = std::stof(argv[i + 1]);
+		}
+		else if (arg == "--pressure-layout")
+		{
+			if (value == "unpacked")
+			{
+				vars.pressureLayout = PressureLayout::Unpacked;
+			}
+			else if (value == "packed")
+			{
+				vars.pressureLayout = PressureLayout::Packed;
+			}
+			else
+			{
+				throw std::invalid_argument{"Unknown pressure layout: " + std::string{value}};
+			}
+		}
+		else if (arg == "--refinement-passes")
+		{
+			vars.refinementPasses = std::stoul(argv[i + 1]);
+		}
+		else if (arg == "--refinement-sweeps")
+		{
+			vars.refinementSweeps = std::stoul(argv[i + 1]);
+		}
+		else if (arg == "--pcg-tolerance")
+		{
+			vars.pcgTolerance = std::stof(argv[i + 1]);
+		}
+		else if (arg == "--pcg-max-iterations")
+		{
+			vars.pcgMaxIterations = std::stoul(argv[i + 1]);
+		}
+		else if (arg == "--pcg-check-interval")
+		{
+			vars.pcgCheckInterval = std::max<std::size_t>(std::stoul(argv[i + 1]), 1);
+		}
+		else
+		{
+			throw std::invalid_argument{"Unknown option: " + std::string{arg}};
+		}
+
+		++i;
+	}
+
+	if (IsPeriodic(vars, BoundarySide::Left) != IsPeriodic(vars, BoundarySide::Right) || IsPeriodic(vars, BoundarySide::Bottom) != IsPeriodic(vars, BoundarySide::Top))
+	{
+		throw std::invalid_argument{"Periodic boundaries have to be set on opposite sides"};
+	}
+
+	// Only the Jacobi and Chebyshev sweeps know the Neumann faces of the obstacles, see CStdGLFluidSolver::SolvePressure
+	if (!vars.obstacleMask.empty())
+	{
+		if (vars.poissonSolver != PoissonSolver::Jacobi && vars.poissonSolver != PoissonSolver::Chebyshev)
+		{
+			throw std::invalid_argument{"Obstacles need the jacobi or chebyshev poisson solver"};
+		}
+		if (vars.projection != ProjectionMethod::Iterative)
+		{
+			throw std::invalid_argument{"Obstacles need the iterative projection"};
+		}
+		if (vars.pressureLayout != PressureLayout::Unpacked || vars.refinementPasses > 0)
+		{
+			throw std::invalid_argument{"Obstacles need the unpacked pressure layout without refinement passes"};
+		}
+	}
+}
+
+CStdChebyshevWeights::CStdChebyshevWeights(const float beta, const std::int32_t width, const std::int32_t height, const std::size_t iterations)
+	: omega{1.0f}, iteration{0}
+{
+	static constexpr float Pi{3.14159265f};
+	// The spectrum bound is narrowed until the modes on it are damped by 1 / cosh(3) = 0.1 within the sweep budget.
+	// Small grids keep their true bound, on large ones it would take about max(width, height) sweeps to beat plain Jacobi.
+	static constexpr float BudgetDamping{3.0f};
+
+	// With beta > 4 the constant mode bounds the spectrum, otherwise it is the null space and the lowest periodic mode does
+	const float radius{beta > 4.0f ? 4.0f / beta : (2.0f + 2.0f * std::cos(2.0f * Pi / std::max(width, height))) / beta};
+	const float budgetRadius{1.0f / std::cosh(BudgetDamping / std::max<std::size_t>(iterations, 1))};
+	const float rho{std::min(radius, budgetRadius)};
+	rhoSquared = rho * rho;
+}
+
+float CStdChebyshevWeights::Next()
+{
+	switch (iteration++)
+	{
+	case 0:
+		omega = 1.0f;
+		break;
+	case 1:
+		omega = 1.0f / (1.0f - 0.5f * rhoSquared);
+		break;
+	default:
+		omega = 1.0f / (1.0f - 0.25f * rhoSquared * omega);
+		break;
+	}
+
+	return omega;
+}
\ No newline at end of file
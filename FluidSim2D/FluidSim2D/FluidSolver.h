@@ -0,0 +1,269 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ImpulseState.h"
+
+// GL solver only: Fragment draws every pass as a full-screen quad, Compute dispatches the kernels of simulation.comp
+enum class SimulationBackend : std::uint8_t
+{
+	Fragment,
+	Compute
+};
+
+enum class PoissonSolver : std::uint8_t
+{
+	Jacobi,
+	Multigrid,
+	RedBlackSOR,
+	ConjugateGradient,
+	Chebyshev
+};
+
+enum class ProjectionMethod : std::uint8_t
+{
+	Iterative,
+	Spectral
+};
+
+enum class PressureLayout : std::uint8_t
+{
+	Unpacked,
+	Packed
+};
+
+// How the stencil passes read their neighbours, Auto picks Gather where the driver supports it
+enum class StencilFetch : std::uint8_t
+{
+	Auto,
+	Filtered,
+	TexelFetch,
+	Gather
+};
+
+enum class MultigridCycle : std::uint8_t
+{
+	V,
+	F
+};
+
+// GL solver only: storage format of a simulation field. fp32 doubles the memory and bandwidth of fp16,
+// scalar fields leave the second channel of the RG formats unused.
+enum class FieldFormat : std::uint8_t
+{
+	R16F,
+	R32F,
+	RG16F,
+	RG32F
+};
+
+enum class PoissonSystem : std::uint8_t
+{
+	Diffusion,
+	Pressure
+};
+
+// Velocity condition of one side of the domain. The one cell rim of the velocity field holds ghost cells,
+// SetBounds derives them from the interior: NoSlip negates the velocity, FreeSlip only its normal component,
+// Inflow sets inflowVelocity, Outflow copies it and Periodic takes the interior cell next to the opposite side.
+enum class BoundaryCondition : std::uint8_t
+{
+	NoSlip,
+	FreeSlip,
+	Inflow,
+	Outflow,
+	Periodic
+};
+
+// Index into Variables::boundaries
+enum class BoundarySide : std::uint8_t
+{
+	Left,
+	Right,
+	Bottom,
+	Top
+};
+
+// Outcome of the last finished solve of one Poisson system
+struct PoissonStatistics
+{
+	// Sweeps, multigrid cycles or red-black SOR iterations
+	std::size_t iterations{0};
+	// Relative L2 norm |alpha * b - A * x| / |alpha * b| and the largest absolute residual, negative while unknown
+	float residual{-1.0f};
+	float maxResidual{-1.0f};
+};
+
+// GL solver only: passes that are merged into their neighbours, each one can be switched on by itself to compare pass counts and bandwidth
+struct FusedPasses
+{
+	// Vorticity confinement in one pass, the vorticity of the 3x3 neighbourhood is computed on the fly from the velocity
+	bool vorticity{false};
+	// U = W - grad(P) in the pass that computes grad(P)
+	bool gradientSubtract{false};
+	// div(W) in the first sweep of a Jacobi or Chebyshev pressure solve, which stores it on the side for the other sweeps
+	bool divergence{false};
+	// The Poisson solve only copies right hand sides its sweeps would overwrite
+	bool copies{false};
+};
+
+// GL solver only: formats of the simulation fields. The velocity needs two channels.
+// The divergence, the pressure gradient and the right hand side copies of the Poisson solves are kept in velocity buffers and share its format.
+struct FieldFormats
+{
+	FieldFormat velocity{FieldFormat::RG16F};
+	FieldFormat pressure{FieldFormat::R16F};
+	FieldFormat vorticity{FieldFormat::R16F};
+};
+
+// Simulation constants shared by every solver backend
+struct Variables
+{
+	float advectionDissipation{0.99f};
+	float gridScale{0.3f};
+	float vorticity{0.005f};
+	float viscosity{0.001f};
+	float splatRadius{0.003f};
+	bool droplets{false};
+
+	// Indexed by BoundarySide, periodic sides come in opposite pairs
+	std::array<BoundaryCondition, 4> boundaries{BoundaryCondition::NoSlip, BoundaryCondition::NoSlip, BoundaryCondition::NoSlip, BoundaryCondition::NoSlip};
+	glm::vec2 inflowVelocity{0.0f, 0.0f};
+
+	// GL solver only: PGM image of the solid cells inside the domain, empty for none. See CStdObstacleMask.
+	// The mask moves by obstacleVelocity cells per second and wraps around, its obstacle field is rebuilt every time it moved a whole cell.
+	std::string obstacleMask;
+	glm::vec2 obstacleVelocity{0.0f, 0.0f};
+
+	SimulationBackend backend{SimulationBackend::Fragment};
+	StencilFetch stencilFetch{StencilFetch::Auto};
+	FusedPasses fusedPasses;
+	FieldFormats fieldFormats;
+
+	PoissonSolver poissonSolver{PoissonSolver::Jacobi};
+	// Jacobi and Chebyshev stop at poissonMaxIterations or once the relative residual drops below poissonTolerance (0 disables the check).
+	// The residual is computed every poissonCheckInterval iterations.
+	std::size_t poissonMaxIterations{30};
+	float poissonTolerance{0.0f};
+	std::size_t poissonCheckInterval{4};
+	// Compute backend only: Jacobi runs jacobiBlockSweeps (2 to 8) sweeps per dispatch in shared memory, 1 runs one per dispatch.
+	// Chebyshev keeps one sweep per dispatch, it needs x(k - 1) of every cell.
+	std::size_t jacobiBlockSweeps{1};
+	// Spectral solves the periodic pressure system exactly with a Hartley transform, diffusion keeps using poissonSolver.
+	// GL solver: a line of the grid has to fit into compute shared memory, 32 KiB (the GL minimum) hold up to 2048 cells.
+	// A larger initial grid is rejected, grids that grow past it on resize use the iterative projection.
+	ProjectionMethod projection{ProjectionMethod::Iterative};
+	// Multigrid halves the grid while both sizes are even, 1024 or 2048 get deep hierarchies while 802 stops at 401
+	MultigridCycle multigridCycle{MultigridCycle::V};
+	std::size_t multigridCycles{2};
+	std::size_t multigridSmoothingSteps{2};
+
+	// One iteration updates the red and then the black cells in place. Needs even grid sizes: with an odd one the periodic wrap
+	// makes cells on opposite sides neighbours of the same color, other sizes run poissonMaxIterations Jacobi sweeps instead.
+	std::size_t sorIterations{15};
+	float sorOmega{1.0f};
+
+	// GL pressure solve only: Packed keeps four cells per RGBA32F texel while Jacobi or Chebyshev run poissonMaxIterations sweeps.
+	// Needs even grid sizes, other sizes use the unpacked layout.
+	PressureLayout pressureLayout{PressureLayout::Unpacked};
+
+	// GL pressure solve only: refinementPasses > 0 wraps the Jacobi, Chebyshev or SOR sweeps into an fp32 iterative refinement.
+	// Every pass computes the residual of the fp32 solution and solves for the correction with refinementSweeps sweeps in the pressure format.
+	std::size_t refinementPasses{0};
+	std::size_t refinementSweeps{10};
+
+	// Stops once |r| <= pcgTolerance * |alpha * b|, the residual is only checked every pcgCheckInterval iterations.
+	// The GL solver reads the checks back without waiting, so it can run a few intervals past the one that converged.
+	float pcgTolerance{1e-3f};
+	std::size_t pcgMaxIterations{100};
+	std::size_t pcgCheckInterval{4};
+};
+
+// Option the program handles itself, ParseVariables skips it and its value
+struct ProgramOption
+{
+	std::string_view name;
+	bool takesValue;
+};
+
+// Overrides vars from command line options. Options that are neither listed below nor in programOptions throw std::invalid_argument.
+// --poisson-solver jacobi|chebyshev|multigrid|sor|pcg --poisson-max-iterations <count> --poisson-tolerance <relative> --poisson-check-interval <count>
+// --jacobi-block-sweeps <count>
+// --projection iterative|spectral --multigrid-cycle v|f --multigrid-cycles <count> --multigrid-smoothing <count>
+// --sor-iterations <count> --sor-omega <factor> --pcg-tolerance <relative> --pcg-max-iterations <count> --pcg-check-interval <count>
+// --backend fragment|compute --stencil-fetch auto|filtered|texel-fetch|gather --pressure-layout unpacked|packed --refinement-passes <count> --refinement-sweeps <count>
+// --fuse all|none|<comma separated list of vorticity, gradient-subtract, divergence, copies>
+// --boundary <condition>|<left>,<right>,<bottom>,<top> with the conditions no-slip|free-slip|inflow|outflow|periodic --inflow-velocity <x>,<y>
+// --obstacles <pgm file> --obstacle-velocity <x>,<y>, obstacles need the jacobi or chebyshev solver with the iterative projection, unpacked and unrefined
+// --velocity-format rg16f|rg32f --pressure-format <format> --vorticity-format <format> with the formats r16f|r32f|rg16f|rg32f
+void ParseVariables(int argc, char *argv[], Variables &vars, std::initializer_list<ProgramOption> programOptions = {});
+
+// Relaxation weights of the Chebyshev semi-iterative method on top of Jacobi:
+//   x(k + 1) = omega(k + 1) * (jacobi(x(k)) - x(k - 1)) + x(k - 1)
+// The Jacobi iteration matrix (xL + xR + xB + xT) / beta of a width x height grid has its spectrum in [-rho, rho],
+// rho is derived from beta and the lowest nonconstant mode, which the singular periodic pressure system needs,
+// and capped by the number of sweeps that are going to run.
+class CStdChebyshevWeights
+{
+public:
+	CStdChebyshevWeights(float beta, std::int32_t width, std::int32_t height, std::size_t iterations);
+
+public:
+	// The first sweep is plain Jacobi (omega = 1), it does not read x(k - 1)
+	float Next();
+
+private:
+	float rhoSquared;
+	float omega;
+	std::size_t iteration;
+};
+
+// Common step interface of the GL and the CPU solver.
+// One call to Step runs the pass sequence
+// advect -> impulse -> vorticity confinement -> diffusion -> projection -> bounds.
+class CStdFluidSolver
+{
+public:
+	CStdFluidSolver(const Variables &vars, std::int32_t width, std::int32_t height)
+		: vars{vars}, width{width}, height{height}, gridScale{1.0f / width, 1.0f / height} {}
+	CStdFluidSolver(const CStdFluidSolver &) = delete;
+	virtual ~CStdFluidSolver() = default;
+
+public:
+	virtual void Step(float dt, const ImpulseState &impulseState) = 0;
+	virtual void Resize(std::int32_t newWidth, std::int32_t newHeight) = 0;
+
+	// Row-major copy of the velocity field, row 0 is the bottom row
+	virtual std::vector<glm::vec2> GetVelocity() const = 0;
+
+	// The GL solver reads residuals back asynchronously, its statistics lag a few frames behind
+	const PoissonStatistics &GetPoissonStatistics(PoissonSystem system) const { return poissonStatistics[static_cast<std::size_t>(system)]; }
+
+	std::int32_t GetWidth() const { return width; }
+	std::int32_t GetHeight() const { return height; }
+
+protected:
+	// See Variables::sorIterations
+	bool UsesRedBlackSOR() const { return vars.poissonSolver == PoissonSolver::RedBlackSOR && width % 2 == 0 && height % 2 == 0; }
+
+	void SetSize(std::int32_t newWidth, std::int32_t newHeight)
+	{
+		width = newWidth;
+		height = newHeight;
+		gridScale = glm::vec2{1.0f / width, 1.0f / height};
+	}
+
+protected:
+	const Variables &vars;
+	std::int32_t width;
+	std::int32_t height;
+	glm::vec2 gridScale;
+	std::array<PoissonStatistics, 2> poissonStatistics;
+};
@@ -0,0 +1,293 @@
+#include "FrameGraph.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+namespace
+{
+	constexpr std::size_t None{std::numeric_limits<std::size_t>::max()};
+}
+
+void CStdRenderTargetPool::Lease::Release()
+{
+	if (entry)
+	{
+		entry->leased = false;
+		entry = nullptr;
+	}
+}
+
+CStdRenderTargetPool::Lease CStdRenderTargetPool::Acquire(const Desc &desc)
+{
+	for (std::size_t i{0}; i < entries.size(); ++i)
+	{
+		Entry &entry{*entries[i]};
+		if (!entry.leased && entry.desc == desc)
+		{
+			entry.leased = entry.acquired = true;
+			return Lease{&entry, i};
+		}
+	}
+
+	entries.push_back(std::make_unique<Entry>(Entry{desc, CStdFramebuffer{desc.width, desc.height, desc.internalFormat, desc.format}}));
+	Entry &entry{*entries.back()};
+	entry.leased = entry.acquired = true;
+	return Lease{&entry, entries.size() - 1};
+}
+
+void CStdRenderTargetPool::Trim()
+{
+	// Leased entries stay, their lease still points at them
+	entries.erase(std::remove_if(entries.begin(), entries.end(), [](const std::unique_ptr<Entry> &entry)
+	{
+		return !entry->acquired && !entry->leased;
+	}), entries.end());
+
+	for (const std::unique_ptr<Entry> &entry : entries)
+	{
+		entry->acquired = false;
+	}
+}
+
+std::vector<CStdRenderTargetPool::Desc> CStdRenderTargetPool::GetTargets() const
+{
+	std::vector<Desc> targets;
+	targets.reserve(entries.size());
+	for (const std::unique_ptr<Entry> &entry : entries)
+	{
+		targets.push_back(entry->desc);
+	}
+
+	return targets;
+}
+
+CStdRenderTargetPool::Desc CStdRenderTargetPool::GetDesc(const CStdFramebuffer &framebuffer)
+{
+	const CStdTexture &texture{framebuffer.GetTexture()};
+	return {texture.GetWidth(), texture.GetHeight(), texture.GetInternalFormat(), texture.GetFormat()};
+}
+
+CStdFrameGraph::Handle CStdFrameGraph::Builder::Create(const std::string_view name, const CStdRenderTargetPool::Desc &desc)
+{
+	graph.resources.push_back(Resource{std::string{name}, nullptr, desc, nullptr, {}, None, false});
+	const Handle handle{graph.resources.size() - 1};
+	graph.passes[pass].accesses.emplace_back(handle, Access::Create);
+	return handle;
+}
+
+CStdFrameGraph::Handle CStdFrameGraph::Builder::Read(const Handle handle)
+{
+	graph.passes[pass].accesses.emplace_back(handle, Access::Read);
+	return handle;
+}
+
+CStdFrameGraph::Handle CStdFrameGraph::Builder::Write(const Handle handle)
+{
+	if (!graph.resources[handle].imported)
+	{
+		throw std::logic_error{"Transient frame graph resources are written by the pass that creates them: " + graph.resources[handle].name};
+	}
+
+	graph.passes[pass].accesses.emplace_back(handle, Access::Write);
+	return handle;
+}
+
+CStdFrameGraph::Handle CStdFrameGraph::Builder::Modify(const Handle handle)
+{
+	graph.passes[pass].accesses.emplace_back(handle, Access::Modify);
+	return handle;
+}
+
+const CStdFramebuffer &CStdFrameGraph::Resources::Get(const Handle handle) const
+{
+	const Resource &resource{graph.resources[handle]};
+	return resource.imported ? resource.imported->GetFront() : *resource.framebuffer;
+}
+
+const CStdFramebuffer &CStdFrameGraph::Resources::GetTarget(const Handle handle) const
+{
+	const Resource &resource{graph.resources[handle]};
+	return resource.imported ? resource.imported->GetBack() : *resource.framebuffer;
+}
+
+CStdFrameGraph::Handle CStdFrameGraph::Import(const std::string_view name, CStdSwappableFramebuffer &buffer)
+{
+	resources.push_back(Resource{std::string{name}, &buffer, CStdRenderTargetPool::GetDesc(buffer.GetBack()), nullptr, {}, None, false});
+	return resources.size() - 1;
+}
+
+void CStdFrameGraph::AddPass(const std::string_view name, const bool enabled, const SetupFunction &setup, ExecuteFunction execute)
+{
+	passes.push_back(Pass{std::string{name}, enabled, false, {}, std::move(execute)});
+
+	Builder builder{*this, passes.size() - 1};
+	setup(builder);
+}
+
+void CStdFrameGraph::Execute()
+{
+	Cull();
+
+	std::vector<std::size_t> first(resources.size(), None);
+	std::vector<std::size_t> last(resources.size(), None);
+	for (std::size_t i{0}; i < passes.size(); ++i)
+	{
+		if (passes[i].culled)
+		{
+			continue;
+		}
+
+		for (const auto &[handle, access] : passes[i].accesses)
+		{
+			if (access == Access::Create)
+			{
+				first[handle] = i;
+			}
+			else if (!resources[handle].imported && first[handle] == None)
+			{
+				throw std::logic_error{"Frame graph pass " + passes[i].name + " reads " + resources[handle].name + " before any pass creates it"};
+			}
+
+			last[handle] = i;
+		}
+	}
+
+	std::ostringstream log;
+	for (std::size_t i{0}; i < passes.size(); ++i)
+	{
+		const Pass &pass{passes[i]};
+		log << "  " << std::left << std::setw(20) << pass.name << std::right;
+		if (pass.culled)
+		{
+			log << (pass.enabled ? "culled" : "disabled") << "\n";
+			continue;
+		}
+
+		static constexpr const char *AccessNames[]{"create", "read", "write", "modify"};
+		const char *separator{""};
+		for (const auto &[handle, access] : pass.accesses)
+		{
+			log << separator << AccessNames[static_cast<std::size_t>(access)] << " " << resources[handle].name;
+			separator = ", ";
+
+			if (access == Access::Create)
+			{
+				Place(handle, i, last[handle]);
+
+				const Resource &resource{resources[handle]};
+				if (resource.lease)
+				{
+					log << " -> pool target " << resource.lease.GetIndex();
+				}
+				else
+				{
+					log << " -> back buffer of " << resources[resource.owner].name;
+				}
+			}
+		}
+		log << "\n";
+
+		pass.execute(Resources{*this});
+
+		for (const auto &[handle, access] : pass.accesses)
+		{
+			if (access == Access::Write)
+			{
+				resources[handle].imported->SwapBuffers();
+			}
+		}
+
+		// Lifetimes that end here free their target for the next passes
+		for (Handle handle{0}; handle < resources.size(); ++handle)
+		{
+			Resource &resource{resources[handle]};
+			if (!resource.imported && last[handle] == i)
+			{
+				resource.lease.Release();
+				if (resource.owner != None)
+				{
+					resources[resource.owner].lent = false;
+				}
+			}
+		}
+	}
+
+	schedule = log.str();
+	passes.clear();
+	resources.clear();
+}
+
+void CStdFrameGraph::PrintSchedule(std::ostream &stream) const
+{
+	stream << "Frame graph:\n" << schedule;
+}
+
+// Walks backwards, a pass is kept if it touches an imported resource or creates one that a kept pass reads
+void CStdFrameGraph::Cull()
+{
+	std::vector<bool> needed(resources.size(), false);
+	for (std::size_t i{passes.size()}; i-- > 0;)
+	{
+		Pass &pass{passes[i]};
+		pass.culled = !pass.enabled || std::none_of(pass.accesses.begin(), pass.accesses.end(), [&](const std::pair<Handle, Access> &access)
+		{
+			return access.second != Access::Read && (resources[access.first].imported || needed[access.first]);
+		});
+
+		if (pass.culled)
+		{
+			continue;
+		}
+
+		for (const auto &[handle, access] : pass.accesses)
+		{
+			if (access == Access::Read || access == Access::Modify)
+			{
+				needed[handle] = true;
+			}
+		}
+	}
+}
+
+// The back buffer of an imported resource holds nothing between the passes that write it
+void CStdFrameGraph::Place(const Handle handle, const std::size_t first, const std::size_t last)
+{
+	Resource &resource{resources[handle]};
+
+	for (Handle owner{0}; owner < resources.size(); ++owner)
+	{
+		Resource &candidate{resources[owner]};
+		if (!candidate.imported || candidate.lent || !(candidate.desc == resource.desc))
+		{
+			continue;
+		}
+
+		bool touched{false};
+		for (std::size_t i{first}; i <= last && !touched; ++i)
+		{
+			touched = !passes[i].culled && Touches(passes[i], owner);
+		}
+
+		if (!touched)
+		{
+			candidate.lent = true;
+			resource.owner = owner;
+			resource.framebuffer = &candidate.imported->GetBack();
+			return;
+		}
+	}
+
+	resource.lease = pool.Acquire(resource.desc);
+	resource.framebuffer = &resource.lease.Get();
+}
+
+bool CStdFrameGraph::Touches(const Pass &pass, const Handle handle) const
+{
+	return std::any_of(pass.accesses.begin(), pass.accesses.end(), [handle](const std::pair<Handle, Access> &access)
+	{
+		return access.first == handle && (access.second == Access::Write || access.second == Access::Modify);
+	});
+}
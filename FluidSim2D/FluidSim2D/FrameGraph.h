@@ -0,0 +1,193 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Shader.h"
+
+// Framebuffers of one size and format that are handed out for a while and reused afterwards.
+// A target is only handed out again once its lease is gone, targets no lease asked for since the last Trim are freed.
+class CStdRenderTargetPool
+{
+public:
+	struct Desc
+	{
+		std::int32_t width;
+		std::int32_t height;
+		GLenum internalFormat;
+		GLenum format;
+
+		bool operator==(const Desc &other) const
+		{
+			return width == other.width && height == other.height && internalFormat == other.internalFormat && format == other.format;
+		}
+	};
+
+private:
+	struct Entry
+	{
+		Desc desc;
+		CStdFramebuffer framebuffer;
+		bool leased{false};
+		bool acquired{false};
+	};
+
+public:
+	class Lease
+	{
+	public:
+		Lease() : entry{nullptr}, index{0} {}
+		Lease(const Lease &) = delete;
+		Lease(Lease &&other) : Lease{} { swap(*this, other); }
+		~Lease() { Release(); }
+
+		Lease &operator=(Lease &&other)
+		{
+			swap(*this, other);
+			return *this;
+		}
+
+		friend void swap(Lease &first, Lease &second)
+		{
+			using std::swap;
+			swap(first.entry, second.entry);
+			swap(first.index, second.index);
+		}
+
+	public:
+		void Release();
+		const CStdFramebuffer &Get() const { return entry->framebuffer; }
+		// Position in the pool, leases with the same index at different times share their memory
+		std::size_t GetIndex() const { return index; }
+		explicit operator bool() const { return entry; }
+
+	private:
+		Lease(Entry *entry, std::size_t index) : entry{entry}, index{index} {}
+
+	private:
+		Entry *entry;
+		std::size_t index;
+
+		friend class CStdRenderTargetPool;
+	};
+
+public:
+	Lease Acquire(const Desc &desc);
+	// Call once per frame with every lease released
+	void Trim();
+	std::vector<Desc> GetTargets() const;
+
+	static Desc GetDesc(const CStdFramebuffer &framebuffer);
+
+private:
+	std::vector<std::unique_ptr<Entry>> entries;
+};
+
+// Per-frame schedule of the simulation passes. Passes declare the resources they read and write,
+// Execute drops disabled passes and passes whose results nobody reads, and runs the rest in the order they were added.
+// Imported resources are swappable framebuffers that live across frames: Write renders into the back buffer and swaps after the pass,
+// Modify leaves the buffers to the pass, which may update the front in place or swap by itself.
+// Transient resources only live from the pass that creates them to the last pass that reads them. They go into the back buffer
+// of an imported resource with the same format that no pass writes in the meantime, or into a target of the pool otherwise.
+class CStdFrameGraph
+{
+public:
+	using Handle = std::size_t;
+
+	class Builder
+	{
+	public:
+		Handle Create(std::string_view name, const CStdRenderTargetPool::Desc &desc);
+		Handle Read(Handle handle);
+		Handle Write(Handle handle);
+		Handle Modify(Handle handle);
+
+	private:
+		Builder(CStdFrameGraph &graph, std::size_t pass) : graph{graph}, pass{pass} {}
+
+	private:
+		CStdFrameGraph &graph;
+		std::size_t pass;
+
+		friend class CStdFrameGraph;
+	};
+
+	class Resources
+	{
+	public:
+		// The current contents, the front buffer of imported resources
+		const CStdFramebuffer &Get(Handle handle) const;
+		// Where a Write goes, the back buffer of imported resources
+		const CStdFramebuffer &GetTarget(Handle handle) const;
+
+	private:
+		explicit Resources(const CStdFrameGraph &graph) : graph{graph} {}
+
+	private:
+		const CStdFrameGraph &graph;
+
+		friend class CStdFrameGraph;
+	};
+
+	using SetupFunction = std::function<void(Builder &)>;
+	using ExecuteFunction = std::function<void(const Resources &)>;
+
+public:
+	explicit CStdFrameGraph(CStdRenderTargetPool &pool) : pool{pool} {}
+
+public:
+	Handle Import(std::string_view name, CStdSwappableFramebuffer &buffer);
+	// setup runs right away, execute during Execute unless the pass is dropped
+	void AddPass(std::string_view name, bool enabled, const SetupFunction &setup, ExecuteFunction execute);
+	// Runs the frame and clears the passes and resources for the next one
+	void Execute();
+
+	// Passes, resources and their placement of the last Execute
+	void PrintSchedule(std::ostream &stream) const;
+
+private:
+	enum class Access : std::uint8_t
+	{
+		Create,
+		Read,
+		Write,
+		Modify
+	};
+
+	struct Resource
+	{
+		std::string name;
+		CStdSwappableFramebuffer *imported;
+		CStdRenderTargetPool::Desc desc;
+		const CStdFramebuffer *framebuffer;
+		CStdRenderTargetPool::Lease lease;
+		// Imported resource whose back buffer holds this transient one, set on the imported resource while it does
+		Handle owner;
+		bool lent;
+	};
+
+	struct Pass
+	{
+		std::string name;
+		bool enabled;
+		bool culled;
+		std::vector<std::pair<Handle, Access>> accesses;
+		ExecuteFunction execute;
+	};
+
+private:
+	void Cull();
+	void Place(Handle handle, std::size_t first, std::size_t last);
+	bool Touches(const Pass &pass, Handle handle) const;
+
+private:
+	CStdRenderTargetPool &pool;
+	std::vector<Resource> resources;
+	std::vector<Pass> passes;
+	std::string schedule;
+};
@@ -0,0 +1,1849 @@
+#include "GLFluidSolver.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+#include "FFT.h"
+
+CStdGLFluidSolver::CStdGLFluidSolver(const Variables &vars, const std::int32_t width, const std::int32_t height)
+	: CStdFluidSolver{vars, width, height},
+	  velocityBuffer{width, height, GetFieldFormatInfo(vars.fieldFormats.velocity).internalFormat, GetFieldFormatInfo(vars.fieldFormats.velocity).format},
+	  pressureBuffer{width, height, GetFieldFormatInfo(vars.fieldFormats.pressure).internalFormat, GetFieldFormatInfo(vars.fieldFormats.pressure).format},
+	  residualBuffer{width, height, GetFieldFormatInfo(vars.fieldFormats.velocity).internalFormat, GetFieldFormatInfo(vars.fieldFormats.velocity).format},
+	  border{InitBorder()},
+	  frameConstants{sizeof(FrameConstants)},
+	  residualPartials{GetNumComputeGroups() * static_cast<GLsizeiptr>(sizeof(glm::vec4))},
+	  residualResults{NumResidualSlots * sizeof(glm::vec4), GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT},
+	  residualResultsData{static_cast<const glm::vec4 *>(residualResults.Map(0, residualResults.GetSize(), GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT))}
+{
+	glGetIntegerv(GL_MAX_COMPUTE_SHARED_MEMORY_SIZE, &maxComputeSharedMemorySize);
+	if (vars.projection == ProjectionMethod::Spectral && !UsesSpectralProjection())
+	{
+		throw std::invalid_argument{"The spectral projection needs " + std::to_string(GetSpectralSharedMemorySize(std::max(width, height))) +
+			" bytes of compute shared memory at this grid size, the driver has " + std::to_string(maxComputeSharedMemorySize)};
+	}
+
+	if (!vars.obstacleMask.empty())
+	{
+		SetObstacleMask(CStdObstacleMask::Load(vars.obstacleMask));
+	}
+}
+
+// Copies frameBuffer from source to destination
+void CStdGLFluidSolver::CopyBuffers(const CStdFramebuffer &source, const CStdFramebuffer &destination)
+{
+	destination.Bind();
+	copyShaderProgram.Select();
+	BindTexture(copyShaderProgram, "field", source.GetTexture());
+	DrawQuad();
+}
+
+void CStdGLFluidSolver::DrawQuad()
+{
+	quad.Bind();
+	quad.Draw();
+	++passCount;
+}
+
+// Only submits the programs, the driver compiles them in the background if it can. See AreShadersReady and FinishLoadingShaders.
+void CStdGLFluidSolver::LoadShaders()
+{
+	// Every shader gets the per-frame constants, the block only survives linking in the programs that read it
+	const std::string frameConstantsSource{LoadShader("frame_constants.glsl")};
+
+	stencilFetch = ResolveStencilFetch(vars.stencilFetch);
+
+	// The build functions keep copies of the sources, CStdShaderVariants calls them long after LoadShaders returned
+	const auto fragmentProgram = [this, &frameConstantsSource](std::string_view objectLabel, const bool stencil = false) -> SweepVariants::BuildFunction
+	{
+		return [this, label = std::string{objectLabel}, vertexSource = LoadShader("tex_coords.vert"), fragmentSource = LoadShader(std::string{objectLabel} + ".frag"), frameConstantsSource, stencil](CStdGLShaderProgram &shaderProgram, const SweepVariants::Macros &macros)
+		{
+			CStdGLShader texCoordsShader{CStdShader::Type::Vertex, vertexSource};
+			texCoordsShader.AddInclude(frameConstantsSource);
+			texCoordsShader.Compile();
+
+			CStdGLShader shader{CStdShader::Type::Fragment, fragmentSource};
+			shader.AddExtension(SamplerBindingExtension);
+			shader.AddInclude(frameConstantsSource);
+			if (stencil)
+			{
+				SetStencilFetch(shader, stencilFetch);
+			}
+			for (const auto &[key, value] : macros)
+			{
+				shader.SetMacro(key, value);
+			}
+			shader.Compile();
+
+			shaderProgram.AddShader(&texCoordsShader);
+			shaderProgram.AddShader(&shader);
+			shaderProgram.BeginLink();
+			shaderProgram.SetObjectLabel(label);
+			BindFrameConstants(shaderProgram);
+		};
+	};
+
+	const auto newShader = [this, &fragmentProgram](CStdGLShaderProgram &shaderProgram, std::string_view objectLabel, const bool stencil = false)
+	{
+		fragmentProgram(objectLabel, stencil)(shaderProgram, {});
+		loadingPrograms.push_back(&shaderProgram);
+	};
+
+	newShader(advectShaderProgram, "advection");
+	newShader(addImpulseShaderProgram, "add_impulse");
+	newShader(addRadialImpulseShaderProgram, "add_radial_impulse");
+	newShader(vorticityShaderProgram, "vorticity", true);
+	newShader(addVorticityShaderProgram, "add_vorticity");
+	loadingPrograms.push_back(&jacobiVariants.Load(fragmentProgram("jacobi", true)));
+	loadingPrograms.push_back(&chebyshevVariants.Load(fragmentProgram("chebyshev")));
+	newShader(divergenceShaderProgram, "divergence", true);
+	newShader(gradientShaderProgram, "gradient", true);
+	newShader(subtractShaderProgram, "subtract");
+	newShader(boundaryShaderProgram, "boundary");
+	newShader(copyShaderProgram, "copy");
+	newShader(smoothShaderProgram, "smooth");
+	newShader(residualShaderProgram, "residual");
+	newShader(prolongateShaderProgram, "prolongate");
+	newShader(sorShaderProgram, "sor");
+	newShader(packShaderProgram, "pack");
+	newShader(unpackShaderProgram, "unpack");
+	newShader(jacobiPackedShaderProgram, "jacobi_packed");
+	newShader(vorticityConfinementShaderProgram, "vorticity_confinement");
+	newShader(gradientSubtractShaderProgram, "gradient_subtract");
+	newShader(divergenceJacobiShaderProgram, "divergence_jacobi");
+	newShader(obstaclesShaderProgram, "obstacles");
+
+	// Compute kernels share one file per algorithm, the macro selects the pass.
+	// Images that load from a field need its format in the layout qualifier, the kernels pick the macro they use.
+	const std::string velocityFormat{GetFieldFormatInfo(vars.fieldFormats.velocity).imageFormat};
+	const std::string pressureFormat{GetFieldFormatInfo(vars.fieldFormats.pressure).imageFormat};
+	const auto computeProgram = [this, &velocityFormat, &pressureFormat, &frameConstantsSource](const std::string &source, const std::string &pass) -> SweepVariants::BuildFunction
+	{
+		return [this, source, pass, velocityFormat, pressureFormat, frameConstantsSource](CStdGLShaderProgram &shaderProgram, const SweepVariants::Macros &macros)
+		{
+			CStdGLShader shader{CStdShader::Type::Compute, source};
+			shader.SetMacro(pass, "1");
+			shader.SetMacro("VELOCITY_FORMAT", velocityFormat);
+			shader.SetMacro("PRESSURE_FORMAT", pressureFormat);
+			for (const auto &[key, value] : macros)
+			{
+				shader.SetMacro(key, value);
+			}
+			shader.AddInclude(frameConstantsSource);
+			shader.Compile();
+
+			shaderProgram.AddShader(&shader);
+			shaderProgram.BeginLink();
+			shaderProgram.SetObjectLabel(pass);
+			BindFrameConstants(shaderProgram);
+		};
+	};
+
+	const auto newComputeShader = [this, &computeProgram](CStdGLShaderProgram &shaderProgram, const std::string &source, const std::string &pass)
+	{
+		computeProgram(source, pass)(shaderProgram, {});
+		loadingPrograms.push_back(&shaderProgram);
+	};
+
+	const std::string pcgSource{LoadShader("pcg.comp")};
+	newComputeShader(pcgInitShaderProgram, pcgSource, "PCG_INIT");
+	newComputeShader(pcgApplyShaderProgram, pcgSource, "PCG_APPLY");
+	newComputeShader(pcgPreconditionShaderProgram, pcgSource, "PCG_PRECONDITION");
+	newComputeShader(pcgReduceShaderProgram, pcgSource, "PCG_REDUCE");
+	newComputeShader(pcgFinishReductionShaderProgram, pcgSource, "PCG_FINISH_REDUCTION");
+	newComputeShader(pcgCenterShaderProgram, pcgSource, "PCG_CENTER");
+	newComputeShader(pcgStepShaderProgram, pcgSource, "PCG_STEP");
+	newComputeShader(pcgDirectionShaderProgram, pcgSource, "PCG_DIRECTION");
+	newComputeShader(pcgStoreShaderProgram, pcgSource, "PCG_STORE");
+
+	const std::string residualNormSource{LoadShader("residual_norm.comp")};
+	newComputeShader(residualNormReduceShaderProgram, residualNormSource, "RESIDUAL_NORM_REDUCE");
+	newComputeShader(residualNormFinishShaderProgram, residualNormSource, "RESIDUAL_NORM_FINISH");
+
+	// The transform programs depend on the grid size, see EnsureSpectralStorage
+	spectralSource = LoadShader("spectral.comp");
+	newComputeShader(spectralStoreShaderProgram, spectralSource, "SPECTRAL_STORE");
+
+	const std::string refinementSource{LoadShader("refinement.comp")};
+	newComputeShader(refinementInitShaderProgram, refinementSource, "REFINEMENT_INIT");
+	newComputeShader(refinementResidualShaderProgram, refinementSource, "REFINEMENT_RESIDUAL");
+	newComputeShader(refinementScaleShaderProgram, refinementSource, "REFINEMENT_SCALE");
+	newComputeShader(refinementCorrectShaderProgram, refinementSource, "REFINEMENT_CORRECT");
+
+	const std::string simulationSource{LoadShader("simulation.comp")};
+	newComputeShader(simulationAdvectShaderProgram, simulationSource, "SIMULATION_ADVECT");
+	newComputeShader(simulationImpulseShaderProgram, simulationSource, "SIMULATION_IMPULSE");
+	newComputeShader(simulationVorticityShaderProgram, simulationSource, "SIMULATION_VORTICITY");
+	newComputeShader(simulationAddVorticityShaderProgram, simulationSource, "SIMULATION_ADD_VORTICITY");
+	newComputeShader(simulationDivergenceShaderProgram, simulationSource, "SIMULATION_DIVERGENCE");
+	loadingPrograms.push_back(&simulationJacobiVariants.Load(computeProgram(simulationSource, "SIMULATION_JACOBI")));
+	newComputeShader(simulationGradientShaderProgram, simulationSource, "SIMULATION_GRADIENT");
+	newComputeShader(simulationSubtractShaderProgram, simulationSource, "SIMULATION_SUBTRACT");
+	newComputeShader(simulationBoundaryShaderProgram, simulationSource, "SIMULATION_BOUNDARY");
+	newComputeShader(simulationVorticityConfinementShaderProgram, simulationSource, "SIMULATION_VORTICITY_CONFINEMENT");
+	newComputeShader(simulationGradientSubtractShaderProgram, simulationSource, "SIMULATION_GRADIENT_SUBTRACT");
+	newComputeShader(simulationDivergenceJacobiShaderProgram, simulationSource, "SIMULATION_DIVERGENCE_JACOBI");
+	newComputeShader(simulationObstaclesShaderProgram, simulationSource, "SIMULATION_OBSTACLES");
+
+	const std::string obstacleFieldSource{LoadShader("obstacles.comp")};
+	newComputeShader(obstacleSeedShaderProgram, obstacleFieldSource, "OBSTACLE_SEED");
+	newComputeShader(obstacleJumpShaderProgram, obstacleFieldSource, "OBSTACLE_JUMP");
+	newComputeShader(obstacleResolveShaderProgram, obstacleFieldSource, "OBSTACLE_RESOLVE");
+
+	// The halo and with it the shared memory size of the blocked kernel depend on the sweep count
+	if (UsesJacobiBlocking())
+	{
+		CStdGLShader shader{CStdShader::Type::Compute, simulationSource};
+		shader.SetMacro("SIMULATION_JACOBI_BLOCKED", "1");
+		shader.SetMacro("BLOCK_SWEEPS", std::to_string(vars.jacobiBlockSweeps));
+		shader.AddInclude(frameConstantsSource);
+		shader.Compile();
+
+		simulationJacobiBlockedShaderProgram.AddShader(&shader);
+		simulationJacobiBlockedShaderProgram.BeginLink();
+		simulationJacobiBlockedShaderProgram.SetObjectLabel("SIMULATION_JACOBI_BLOCKED");
+		BindFrameConstants(simulationJacobiBlockedShaderProgram);
+		loadingPrograms.push_back(&simulationJacobiBlockedShaderProgram);
+	}
+}
+
+bool CStdGLFluidSolver::AreShadersReady() const
+{
+	return std::all_of(loadingPrograms.begin(), loadingPrograms.end(), [](const CStdGLShaderProgram *const program)
+	{
+		return program->IsLinkComplete();
+	});
+}
+
+void CStdGLFluidSolver::FinishLoadingShaders()
+{
+	for (CStdGLShaderProgram *const program : loadingPrograms)
+	{
+		program->FinishLink();
+	}
+
+	loadingPrograms.clear();
+
+	jacobiVariants.FinishLoad();
+	chebyshevVariants.FinishLoad();
+	simulationJacobiVariants.FinishLoad();
+	sorUniforms = SweepUniforms{sorShaderProgram};
+	jacobiPackedUniforms = SweepUniforms{jacobiPackedShaderProgram};
+}
+
+CStdGLFluidSolver::SweepUniforms::SweepUniforms(const CStdGLShaderProgram &program) :
+	alpha{program.GetUniformHandle<float>("alpha")},
+	beta{program.GetUniformHandle<float>("beta")},
+	omega{program.GetUniformHandle<float>("omega")},
+	obstacles{program.GetUniformHandle<bool>("obstacles")},
+	scalar{program.GetUniformHandle<bool>("scalar")},
+	parity{program.GetUniformHandle<GLint>("parity")}
+{
+}
+
+// textureGather with a component index needs GLSL 4.00 or ARB_gpu_shader5, the stencil shaders are #version 330 and SetStencilFetch enables the extension
+bool CStdGLFluidSolver::SupportsGather()
+{
+	GLint numExtensions{0};
+	glGetIntegerv(GL_NUM_EXTENSIONS, &numExtensions);
+
+	for (GLint i{0}; i < numExtensions; ++i)
+	{
+		if (std::string_view{reinterpret_cast<const char *>(glGetStringi(GL_EXTENSIONS, i))} == "GL_ARB_gpu_shader5")
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+StencilFetch CStdGLFluidSolver::ResolveStencilFetch(const StencilFetch requested)
+{
+	if (requested != StencilFetch::Auto && requested != StencilFetch::Gather)
+	{
+		return requested;
+	}
+
+	return SupportsGather() ? StencilFetch::Gather : StencilFetch::TexelFetch;
+}
+
+void CStdGLFluidSolver::SetStencilFetch(CStdGLShader &shader, const StencilFetch fetch)
+{
+	switch (fetch)
+	{
+	case StencilFetch::TexelFetch:
+		shader.SetMacro("STENCIL_TEXEL_FETCH", "1");
+		break;
+	case StencilFetch::Gather:
+		shader.SetMacro("STENCIL_GATHER", "1");
+		shader.AddExtension("GL_ARB_gpu_shader5");
+		break;
+	default:
+		break;
+	}
+}
+
+void CStdGLFluidSolver::BindFrameConstants(CStdGLShaderProgram &program)
+{
+	program.SetUniformBlockBinding("FrameConstants", FrameConstantsBinding);
+}
+
+// The only uniform upload of the constants per Step, every pass reads the same buffer
+void CStdGLFluidSolver::UpdateFrameConstants(const float dt)
+{
+	const FrameConstants constants{gridScale, vars.gridScale, dt, vars.advectionDissipation, vars.splatRadius, vars.vorticity, 0.0f};
+	frameConstants.SetData(0, sizeof(constants), &constants);
+	frameConstants.BindBase(GL_UNIFORM_BUFFER, FrameConstantsBinding);
+}
+
+// One step as a frame graph, both backends share the pass sequence. The compute backend updates the velocity in place
+// where a pass only touches its own cell, the Poisson solvers other than Jacobi and Chebyshev keep their fragment and compute passes.
+void CStdGLFluidSolver::Step(const float dt, const ImpulseState &impulseState)
+{
+	CStdGLState::Viewport(0, 0, width, height);
+	passCount = 0;
+	jacobiVariants.Poll();
+	chebyshevVariants.Poll();
+	simulationJacobiVariants.Poll();
+	UpdateFrameConstants(dt);
+	UpdateObstacles(dt);
+
+	using Builder = CStdFrameGraph::Builder;
+	using Resources = CStdFrameGraph::Resources;
+
+	const bool compute{vars.backend == SimulationBackend::Compute};
+	const CStdRenderTargetPool::Desc velocityDesc{CStdRenderTargetPool::GetDesc(velocityBuffer.GetFront())};
+	const FieldFormatInfo vorticityFormat{GetFieldFormatInfo(vars.fieldFormats.vorticity)};
+	const CStdRenderTargetPool::Desc vorticityDesc{width, height, vorticityFormat.internalFormat, vorticityFormat.format};
+
+	const CStdFrameGraph::Handle velocity{frameGraph.Import("velocity", velocityBuffer)};
+	const CStdFrameGraph::Handle pressure{frameGraph.Import("pressure", pressureBuffer)};
+	CStdFrameGraph::Handle vorticity{};
+	CStdFrameGraph::Handle divergence{};
+	CStdFrameGraph::Handle gradient{};
+
+	const auto setBounds = [this](const Resources &)
+	{
+		SetBounds();
+	};
+
+	// In place on the compute backend
+	const auto updateVelocity = [velocity, compute](Builder &builder)
+	{
+		if (compute)
+		{
+			builder.Modify(velocity);
+		}
+		else
+		{
+			builder.Write(velocity);
+		}
+	};
+
+#pragma region Advection
+	frameGraph.AddPass("bounds", true, [velocity](Builder &builder) { builder.Modify(velocity); }, setBounds);
+
+	frameGraph.AddPass("advect", true, [velocity](Builder &builder) { builder.Write(velocity); }, [&, this](const Resources &resources)
+	{
+		const CStdTexture &field{resources.Get(velocity).GetTexture()};
+		if (compute)
+		{
+			simulationAdvectShaderProgram.Select();
+			BindTexture(simulationAdvectShaderProgram, "velocity", field);
+			BindTexture(simulationAdvectShaderProgram, "quantity", field);
+			resources.GetTarget(velocity).GetTexture().BindImage(0, GL_WRITE_ONLY);
+			DispatchSimulation();
+			return;
+		}
+
+		resources.GetTarget(velocity).Bind();
+		advectShaderProgram.Select();
+		BindTexture(advectShaderProgram, "quantity", field);
+		BindTexture(advectShaderProgram, "velocity", field);
+		DrawQuad();
+	});
+#pragma endregion
+
+#pragma region Force Application
+	frameGraph.AddPass("impulse", impulseState.IsActive(), updateVelocity, [&, this](const Resources &resources)
+	{
+		const auto diff = impulseState.Delta;
+		const glm::vec3 force{std::clamp(diff.x, -vars.gridScale, vars.gridScale), std::clamp(diff.y, -vars.gridScale, vars.gridScale), 0};
+
+		if (compute)
+		{
+			simulationImpulseShaderProgram.Select();
+			simulationImpulseShaderProgram.SetUniform("position", glm::vec2{impulseState.CurrentPos.x, impulseState.CurrentPos.y} * gridScale);
+			simulationImpulseShaderProgram.SetUniform("force", force);
+			simulationImpulseShaderProgram.SetUniform("radial", glUniform1i, impulseState.Radial);
+			resources.Get(velocity).GetTexture().BindImage(0, GL_READ_WRITE);
+			DispatchSimulation();
+			return;
+		}
+
+		resources.GetTarget(velocity).Bind();
+
+		CStdGLShaderProgram &program{impulseState.Radial ? addRadialImpulseShaderProgram : addImpulseShaderProgram};
+
+		program.Select();
+		program.SetUniform("position", glm::vec2{impulseState.CurrentPos.x, impulseState.CurrentPos.y} * gridScale);
+		BindTexture(program, "velocity", resources.Get(velocity).GetTexture());
+
+		if (!impulseState.Radial)
+		{
+			program.SetUniform("force", force);
+		}
+
+		DrawQuad();
+	});
+#pragma endregion
+
+#pragma region Vorticity
+	// Culled along with the confinement when the vorticity scale is 0
+	frameGraph.AddPass("vorticity", !vars.fusedPasses.vorticity, [&](Builder &builder)
+	{
+		builder.Read(velocity);
+		vorticity = builder.Create("vorticity", vorticityDesc);
+	},
+	[&, this](const Resources &resources)
+	{
+		if (compute)
+		{
+			simulationVorticityShaderProgram.Select();
+			BindTexture(simulationVorticityShaderProgram, "field", resources.Get(velocity).GetTexture());
+			resources.Get(vorticity).GetTexture().BindImage(0, GL_WRITE_ONLY);
+			DispatchSimulation();
+			return;
+		}
+
+		resources.Get(vorticity).Bind();
+		vorticityShaderProgram.Select();
+		BindTexture(vorticityShaderProgram, "velocity", resources.Get(velocity).GetTexture());
+		DrawQuad();
+	});
+#pragma endregion
+
+	frameGraph.AddPass("bounds", true, [velocity](Builder &builder) { builder.Modify(velocity); }, setBounds);
+
+#pragma region Add Vorticity
+	if (vars.fusedPasses.vorticity)
+	{
+		// The curl is recomputed from the bounded velocity. It reads a 2 cell neighbourhood of the velocity, so it cannot run in place.
+		frameGraph.AddPass("vorticity confinement", vars.vorticity != 0.0f, [velocity](Builder &builder) { builder.Write(velocity); }, [&, this](const Resources &resources)
+		{
+			CStdGLShaderProgram &program{compute ? simulationVorticityConfinementShaderProgram : vorticityConfinementShaderProgram};
+			program.Select();
+			BindTexture(program, "velocity", resources.Get(velocity).GetTexture());
+
+			if (compute)
+			{
+				resources.GetTarget(velocity).GetTexture().BindImage(0, GL_WRITE_ONLY);
+				DispatchSimulation();
+			}
+			else
+			{
+				resources.GetTarget(velocity).Bind();
+				DrawQuad();
+			}
+		});
+	}
+	else
+	{
+		frameGraph.AddPass("add vorticity", vars.vorticity != 0.0f, [&](Builder &builder)
+		{
+			builder.Read(vorticity);
+			updateVelocity(builder);
+		},
+		[&, this](const Resources &resources)
+		{
+			if (compute)
+			{
+				simulationAddVorticityShaderProgram.Select();
+				BindTexture(simulationAddVorticityShaderProgram, "field", resources.Get(vorticity).GetTexture());
+				resources.Get(velocity).GetTexture().BindImage(0, GL_READ_WRITE);
+				DispatchSimulation();
+				return;
+			}
+
+			resources.GetTarget(velocity).Bind();
+			addVorticityShaderProgram.Select();
+			BindTexture(addVorticityShaderProgram, "velocity", resources.Get(velocity).GetTexture());
+			BindTexture(addVorticityShaderProgram, "vorticity", resources.Get(vorticity).GetTexture());
+			DrawQuad();
+		});
+	}
+#pragma endregion
+
+#pragma region Diffusion
+	frameGraph.AddPass("diffusion", vars.viscosity > 0.0f, [velocity](Builder &builder) { builder.Modify(velocity); }, [&, this](const Resources &)
+	{
+		const float alpha{(vars.gridScale * vars.gridScale) / (vars.viscosity * dt)};
+		const float beta{alpha + 4.0f};
+		SolvePoissonSystem(velocityBuffer, velocityBuffer.GetFront(), alpha, beta, PoissonSystem::Diffusion);
+	});
+#pragma endregion
+
+#pragma region Projection
+	// Calculate div(W), the fused variant leaves it to the first pressure sweep
+	const bool fusedDivergence{UsesFusedDivergence()};
+	frameGraph.AddPass("divergence", !fusedDivergence, [&](Builder &builder)
+	{
+		builder.Read(velocity);
+		divergence = builder.Create("divergence", velocityDesc);
+	},
+	[&, this](const Resources &resources)
+	{
+		if (compute)
+		{
+			simulationDivergenceShaderProgram.Select();
+			BindTexture(simulationDivergenceShaderProgram, "field", resources.Get(velocity).GetTexture());
+			resources.Get(divergence).GetTexture().BindImage(0, GL_WRITE_ONLY);
+			DispatchSimulation();
+			return;
+		}
+
+		resources.Get(divergence).Bind();
+		divergenceShaderProgram.Select();
+		BindTexture(divergenceShaderProgram, "field", resources.Get(velocity).GetTexture());
+		DrawQuad();
+	});
+
+	// Solve for P in: Laplacian(P) = div(W), the refinement leaves P in its fp32 solution rather than in the pressure field
+	const CStdTexture *pressureField{nullptr};
+	frameGraph.AddPass("pressure", true, [&](Builder &builder)
+	{
+		builder.Read(velocity);
+		divergence = fusedDivergence ? builder.Create("divergence", velocityDesc) : builder.Read(divergence);
+		builder.Modify(pressure);
+	},
+	[&, this](const Resources &resources)
+	{
+		pressureField = &SolvePressure(resources.Get(velocity), resources.Get(divergence));
+	});
+
+	if (vars.fusedPasses.gradientSubtract)
+	{
+		// Calculate U = W - grad(P) without storing grad(P)
+		frameGraph.AddPass("gradient subtract", true, [&](Builder &builder)
+		{
+			builder.Read(pressure);
+			updateVelocity(builder);
+		},
+		[&, this](const Resources &resources)
+		{
+			if (compute)
+			{
+				simulationGradientSubtractShaderProgram.Select();
+				BindTexture(simulationGradientSubtractShaderProgram, "field", *pressureField);
+				resources.Get(velocity).GetTexture().BindImage(0, GL_READ_WRITE);
+				DispatchSimulation();
+				return;
+			}
+
+			resources.GetTarget(velocity).Bind();
+			gradientSubtractShaderProgram.Select();
+			BindTexture(gradientSubtractShaderProgram, "field", *pressureField);
+			BindTexture(gradientSubtractShaderProgram, "velocity", resources.Get(velocity).GetTexture());
+			DrawQuad();
+		});
+	}
+	else
+	{
+		// Calculate grad(P), it needs two channels even if the pressure has one
+		frameGraph.AddPass("gradient", true, [&](Builder &builder)
+		{
+			builder.Read(pressure);
+			gradient = builder.Create("gradient", velocityDesc);
+		},
+		[&, this](const Resources &resources)
+		{
+			CStdGLShaderProgram &program{compute ? simulationGradientShaderProgram : gradientShaderProgram};
+			program.Select();
+			BindTexture(program, "field", *pressureField);
+
+			if (compute)
+			{
+				resources.Get(gradient).GetTexture().BindImage(0, GL_WRITE_ONLY);
+				DispatchSimulation();
+			}
+			else
+			{
+				resources.Get(gradient).Bind();
+				DrawQuad();
+			}
+		});
+
+		// Calculate U = W - grad(P) where div(U)=0
+		frameGraph.AddPass("subtract", true, [&](Builder &builder)
+		{
+			builder.Read(gradient);
+			updateVelocity(builder);
+		},
+		[&, this](const Resources &resources)
+		{
+			if (compute)
+			{
+				simulationSubtractShaderProgram.Select();
+				BindTexture(simulationSubtractShaderProgram, "gradient", resources.Get(gradient).GetTexture());
+				resources.Get(velocity).GetTexture().BindImage(0, GL_READ_WRITE);
+				DispatchSimulation();
+				return;
+			}
+
+			resources.GetTarget(velocity).Bind();
+			subtractShaderProgram.Select();
+			BindTexture(subtractShaderProgram, "a", resources.Get(velocity).GetTexture());
+			BindTexture(subtractShaderProgram, "b", resources.Get(gradient).GetTexture());
+			DrawQuad();
+		});
+	}
+
+	frameGraph.AddPass("bounds", true, [velocity](Builder &builder) { builder.Modify(velocity); }, setBounds);
+#pragma endregion
+
+	frameGraph.Execute();
+	targetPool.Trim();
+}
+
+void CStdGLFluidSolver::Resize(const std::int32_t newWidth, const std::int32_t newHeight)
+{
+	SetSize(newWidth, newHeight);
+	// The grid size is one of their axes
+	jacobiVariants.Clear();
+	simulationJacobiVariants.Clear();
+
+	// The copies draw into the new size, creating the framebuffers leaves the viewport alone
+	CStdGLState::Viewport(0, 0, width, height);
+	ResizeFramebuffer(velocityBuffer, width, height);
+	ResizeFramebuffer(pressureBuffer, width, height);
+	ResizeFramebuffer(residualBuffer, width, height);
+	residualPartials = CStdBuffer{GetNumComputeGroups() * static_cast<GLsizeiptr>(sizeof(glm::vec4))};
+
+	if (obstacles)
+	{
+		EnsureObstacleStorage(std::move(obstacles->source));
+	}
+}
+
+std::vector<CStdGLFluidSolver::FieldMemory> CStdGLFluidSolver::GetFieldMemory() const
+{
+	const std::size_t cells{static_cast<std::size_t>(width) * height};
+	const auto field = [cells](const char *const name, const FieldFormat format, const std::size_t buffers)
+	{
+		const std::size_t bytesPerPass{cells * GetFieldFormatInfo(format).bytesPerTexel};
+		return FieldMemory{name, format, buffers, buffers * bytesPerPass, bytesPerPass};
+	};
+
+	std::vector<FieldMemory> memory{
+		field("velocity", vars.fieldFormats.velocity, 2),
+		field("pressure", vars.fieldFormats.pressure, 2),
+		field("residual", vars.fieldFormats.velocity, 1)
+	};
+
+	// Transient fields that found no free back buffer, targets of the same format are reported separately
+	for (const CStdRenderTargetPool::Desc &target : targetPool.GetTargets())
+	{
+		for (const FieldFormat format : {FieldFormat::R16F, FieldFormat::R32F, FieldFormat::RG16F, FieldFormat::RG32F})
+		{
+			if (GetFieldFormatInfo(format).internalFormat == target.internalFormat)
+			{
+				memory.push_back(field("transient", format, 1));
+			}
+		}
+	}
+
+	return memory;
+}
+
+CStdGLFluidSolver::FieldFormatInfo CStdGLFluidSolver::GetFieldFormatInfo(const FieldFormat format)
+{
+	switch (format)
+	{
+	case FieldFormat::R16F:
+		return {GL_R16F, GL_RED, "r16f", "R16F", 2};
+	case FieldFormat::R32F:
+		return {GL_R32F, GL_RED, "r32f", "R32F", 4};
+	case FieldFormat::RG16F:
+		return {GL_RG16F, GL_RG, "rg16f", "RG16F", 4};
+	case FieldFormat::RG32F:
+		return {GL_RG32F, GL_RG, "rg32f", "RG32F", 8};
+	}
+
+	throw std::invalid_argument{"Unknown field format"};
+}
+
+std::vector<glm::vec2> CStdGLFluidSolver::GetVelocity() const
+{
+	std::vector<glm::vec2> velocity(static_cast<std::size_t>(width) * height);
+	glGetTextureImage(velocityBuffer.GetFront().GetTexture().GetTexture(), 0, GL_RG, GL_FLOAT, static_cast<GLsizei>(velocity.size() * sizeof(glm::vec2)), velocity.data());
+	return velocity;
+}
+
+// Rewrites the velocity rim from the interior with the ghost cell rules of boundary.glsl, in place and without touching any other cell
+void CStdGLFluidSolver::SetBounds()
+{
+	const auto &sides = vars.boundaries;
+	const glm::ivec4 conditions{static_cast<GLint>(sides[0]), static_cast<GLint>(sides[1]), static_cast<GLint>(sides[2]), static_cast<GLint>(sides[3])};
+
+	if (vars.backend == SimulationBackend::Compute)
+	{
+		// One invocation per rim cell
+		const GLuint numRimCells{2 * static_cast<GLuint>(width + height)};
+		simulationBoundaryShaderProgram.Select();
+		simulationBoundaryShaderProgram.SetUniform("conditions", glUniform4i, conditions.x, conditions.y, conditions.z, conditions.w);
+		simulationBoundaryShaderProgram.SetUniform("inflow", vars.inflowVelocity);
+		velocityBuffer.GetFront().GetTexture().BindImage(0, GL_READ_WRITE);
+		glDispatchCompute((numRimCells + ComputeGroupSize * ComputeGroupSize - 1) / (ComputeGroupSize * ComputeGroupSize), 1, 1);
+		glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT);
+		++passCount;
+
+		if (UsesObstacles())
+		{
+			simulationObstaclesShaderProgram.Select();
+			BindTexture(simulationObstaclesShaderProgram, "obstacleField", obstacles->field.GetTexture());
+			velocityBuffer.GetFront().GetTexture().BindImage(0, GL_READ_WRITE);
+			DispatchSimulation();
+		}
+		return;
+	}
+
+	// The lines only read interior cells, so they can sample the render target they draw into
+	velocityBuffer.GetFront().Bind();
+	boundaryShaderProgram.Select();
+	boundaryShaderProgram.SetUniform("conditions", glUniform4i, conditions.x, conditions.y, conditions.z, conditions.w);
+	boundaryShaderProgram.SetUniform("inflow", vars.inflowVelocity);
+	BindTexture(boundaryShaderProgram, "field", velocityBuffer.GetFront().GetTexture());
+
+	for (CStdLine *const line : {&border.top, &border.left, &border.bottom, &border.right})
+	{
+		line->Bind();
+		line->Draw();
+	}
+	++passCount;
+
+	// Every fragment only reads its own texel, the barrier makes the rim visible to it
+	if (UsesObstacles())
+	{
+		glTextureBarrier();
+		obstaclesShaderProgram.Select();
+		BindTexture(obstaclesShaderProgram, "field", velocityBuffer.GetFront().GetTexture());
+		BindTexture(obstaclesShaderProgram, "obstacleField", obstacles->field.GetTexture());
+		DrawQuad();
+	}
+}
+
+void CStdGLFluidSolver::SetObstacleMask(const CStdObstacleMask &mask)
+{
+	EnsureObstacleStorage(mask);
+}
+
+void CStdGLFluidSolver::EnsureObstacleStorage(CStdObstacleMask source)
+{
+	if (!obstacles)
+	{
+		obstacles = std::make_unique<ObstacleStorage>();
+	}
+
+	ObstacleStorage &storage{*obstacles};
+	std::vector<std::uint8_t> cells{source.Resample(width, height).GetCells()};
+
+	// Rows of the R8 mask are not padded to 4 bytes
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	storage.mask = CStdTexture{width, height, GL_R8, GL_RED, GL_UNSIGNED_BYTE, cells.data()};
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	if (storage.field.GetTexture().GetWidth() != width || storage.field.GetTexture().GetHeight() != height)
+	{
+		storage.seeds[0] = CStdTexture{width, height, GL_RGBA32F, GL_RGBA, GL_FLOAT};
+		storage.seeds[1] = CStdTexture{width, height, GL_RGBA32F, GL_RGBA, GL_FLOAT};
+		storage.field = CStdFramebuffer{width, height};
+	}
+
+	storage.source = std::move(source);
+	storage.dirty = true;
+}
+
+// Moves the mask by obstacleVelocity and rebuilds the obstacle field once it changed by a whole cell
+void CStdGLFluidSolver::UpdateObstacles(const float dt)
+{
+	if (!obstacles)
+	{
+		return;
+	}
+
+	ObstacleStorage &storage{*obstacles};
+	const glm::vec2 size{static_cast<float>(width), static_cast<float>(height)};
+	storage.position = glm::mod(storage.position + vars.obstacleVelocity * dt, size);
+
+	const glm::ivec2 offset{glm::clamp(glm::ivec2{glm::floor(storage.position)}, glm::ivec2{0}, glm::ivec2{width - 1, height - 1})};
+	if (!storage.dirty && offset == storage.offset)
+	{
+		return;
+	}
+
+	storage.offset = offset;
+	storage.dirty = false;
+	BuildObstacleField();
+}
+
+// Jump flooding with steps from half the grid size down to one cell, see obstacles.comp
+void CStdGLFluidSolver::BuildObstacleField()
+{
+	ObstacleStorage &storage{*obstacles};
+
+	obstacleSeedShaderProgram.Select();
+	obstacleSeedShaderProgram.SetUniform("offset", glUniform2i, storage.offset.x, storage.offset.y);
+	BindTexture(obstacleSeedShaderProgram, "mask", storage.mask);
+	storage.seeds[0].BindImage(0, GL_WRITE_ONLY);
+	DispatchSimulation();
+
+	GLint jump{1};
+	while (2 * jump < std::max(width, height))
+	{
+		jump *= 2;
+	}
+
+	std::size_t current{0};
+	obstacleJumpShaderProgram.Select();
+	for (; jump > 0; jump /= 2)
+	{
+		obstacleJumpShaderProgram.SetUniform("jump", glUniform1i, jump);
+		BindTexture(obstacleJumpShaderProgram, "seeds", storage.seeds[current]);
+		storage.seeds[1 - current].BindImage(0, GL_WRITE_ONLY);
+		DispatchSimulation();
+		current = 1 - current;
+	}
+
+	obstacleResolveShaderProgram.Select();
+	BindTexture(obstacleResolveShaderProgram, "seeds", storage.seeds[current]);
+	storage.field.GetTexture().BindImage(0, GL_WRITE_ONLY);
+	DispatchSimulation();
+}
+
+auto CStdGLFluidSolver::InitBorder() -> Border
+{
+	const glm::vec2 c{1.0f - 0.5f / width, 1.0f - 0.5f / height};
+
+	// Texture space is y-up, so the top row sits at +c
+	return Border
+	{
+		{{ c.x,  c.y}, {-c.x,  c.y}},
+		{{-c.x,  c.y}, {-c.x, -c.y}},
+		{{-c.x, -c.y}, { c.x, -c.y}},
+		{{ c.x, -c.y}, { c.x,  c.y}}
+	};
+}
+
+// The unit comes from the layout(binding) of the sampler, samplers the program does not use are skipped
+void CStdGLFluidSolver::BindTexture(const CStdGLShaderProgram &program, const std::string_view key, const CStdTexture &texture)
+{
+	if (const GLint unit{program.GetSamplerUnit(key)}; unit != -1)
+	{
+		texture.Bind(unit);
+	}
+}
+
+// Runs the configured pressure solve on the divergence and returns the texture holding P, the fp32 solution if there is one.
+// With the fused divergence, divergence is only written by the first sweep, which computes it from velocity.
+const CStdTexture &CStdGLFluidSolver::SolvePressure(const CStdFramebuffer &velocity, const CStdFramebuffer &divergence)
+{
+	const float alpha{-vars.gridScale * vars.gridScale};
+
+	// Only the Jacobi and Chebyshev sweeps know the Neumann faces of the obstacles, ParseVariables rejects the other solvers with obstacles
+	if (UsesObstacles())
+	{
+		SolveJacobi(pressureBuffer, divergence, alpha, 4.0f, PoissonSystem::Pressure);
+	}
+	else if (UsesSpectralProjection())
+	{
+		SolveSpectral(pressureBuffer.GetFront(), divergence, alpha, 4.0f);
+	}
+	else if (UsesPackedPressure())
+	{
+		SolvePacked(pressureBuffer, divergence, alpha, 4.0f, PoissonSystem::Pressure);
+	}
+	else if (UsesRefinement())
+	{
+		SolveRefined(pressureBuffer, divergence, alpha, 4.0f, PoissonSystem::Pressure);
+		return refinement->solution;
+	}
+	else if (UsesFusedDivergence())
+	{
+		SolveJacobi(pressureBuffer, divergence, alpha, 4.0f, PoissonSystem::Pressure, &velocity);
+	}
+	else
+	{
+		SolvePoissonSystem(pressureBuffer, divergence, alpha, 4.0f, PoissonSystem::Pressure);
+	}
+
+	return pressureBuffer.GetFront().GetTexture();
+}
+
+// The right hand side is copied into a target of the pool, the solvers overwrite both buffers of swappableBuffer.
+// With the copy elision a right hand side from elsewhere is used as it is.
+void CStdGLFluidSolver::SolvePoissonSystem(CStdSwappableFramebuffer &swappableBuffer, const CStdFramebuffer &initialValue, float alpha, float beta, const PoissonSystem system)
+{
+	const bool copy{!vars.fusedPasses.copies || &initialValue == &swappableBuffer.GetFront() || &initialValue == &swappableBuffer.GetBack()};
+	CStdRenderTargetPool::Lease copyTarget;
+	if (copy)
+	{
+		copyTarget = targetPool.Acquire(CStdRenderTargetPool::GetDesc(initialValue));
+		CopyBuffers(initialValue, copyTarget.Get());
+	}
+
+	const CStdFramebuffer &rightHandSide{copy ? copyTarget.Get() : initialValue};
+
+	// Multigrid and SOR run a fixed amount of work, the residual is only checked once for the statistics
+	if (vars.poissonSolver == PoissonSolver::Multigrid || UsesRedBlackSOR())
+	{
+		ConvergenceState &state{convergence[static_cast<std::size_t>(system)]};
+		PollResidualChecks(system);
+		++state.solve;
+
+		const bool multigrid{vars.poissonSolver == PoissonSolver::Multigrid};
+		if (multigrid)
+		{
+			SolveMultigrid(swappableBuffer, rightHandSide, alpha, beta, system);
+		}
+		else
+		{
+			SolveRedBlackSOR(swappableBuffer.GetFront(), rightHandSide, alpha, beta, vars.sorIterations);
+		}
+
+		IssueResidualCheck(ComputeResidual(swappableBuffer.GetFront(), rightHandSide, alpha, beta), rightHandSide, alpha, system, multigrid ? vars.multigridCycles : vars.sorIterations, true);
+		return;
+	}
+
+	if (vars.poissonSolver == PoissonSolver::ConjugateGradient)
+	{
+		SolveConjugateGradient(swappableBuffer.GetFront(), rightHandSide, alpha, beta, system);
+		return;
+	}
+
+	SolveJacobi(swappableBuffer, rightHandSide, alpha, beta, system);
+}
+
+// PoissonSolver::Chebyshev runs the same loop with chebyshev.frag, which reweights every sweep against x(k - 1) in the back buffer.
+// With jacobiBlockSweeps > 1 the compute backend runs up to that many sweeps per dispatch, a block never runs past a residual check.
+// With a tolerance set, residual checks are issued every poissonCheckInterval iterations without waiting for them.
+// Results that are already back can end the solve early, and every finished solve sets the iteration budget of the next ones:
+// as many iterations as it took to converge, or 50% more if it did not converge.
+// With velocity set the first sweep is DivergenceSweep, it writes rightHandSide = div(velocity) while it runs.
+void CStdGLFluidSolver::SolveJacobi(CStdSwappableFramebuffer &swappableBuffer, const CStdFramebuffer &rightHandSide, const float alpha, const float beta, const PoissonSystem system, const CStdFramebuffer *const velocity)
+{
+	ConvergenceState &state{convergence[static_cast<std::size_t>(system)]};
+	const bool adaptive{vars.poissonTolerance > 0.0f};
+
+	PollResidualChecks(system);
+	++state.solve;
+	state.solveConverged = false;
+
+	const std::size_t iterations{adaptive && state.iterationBudget ? std::min(state.iterationBudget, vars.poissonMaxIterations) : vars.poissonMaxIterations};
+
+	const bool chebyshev{vars.poissonSolver == PoissonSolver::Chebyshev};
+	CStdChebyshevWeights weights{beta, width, height, iterations};
+
+	const bool blocked{UsesJacobiBlocking()};
+	const bool obstacleFaces{system == PoissonSystem::Pressure && UsesObstacles()};
+
+	std::size_t iteration{0};
+	while (iteration < iterations)
+	{
+		if (velocity && iteration == 0)
+		{
+			// Plain Jacobi, the first Chebyshev weight is 1 as well
+			DivergenceSweep(swappableBuffer, rightHandSide, *velocity, alpha, beta);
+			weights.Next();
+			++iteration;
+		}
+		else if (blocked)
+		{
+			std::size_t sweeps{std::min(vars.jacobiBlockSweeps, iterations - iteration)};
+			if (adaptive)
+			{
+				sweeps = std::min(sweeps, vars.poissonCheckInterval - iteration % vars.poissonCheckInterval);
+			}
+
+			JacobiBlock(swappableBuffer, rightHandSide, alpha, beta, sweeps);
+			iteration += sweeps;
+		}
+		else
+		{
+			JacobiSweep(swappableBuffer, rightHandSide, alpha, beta, system, chebyshev ? weights.Next() : 1.0f);
+			++iteration;
+		}
+
+		if (adaptive && iteration % vars.poissonCheckInterval == 0 && iteration < iterations)
+		{
+			IssueResidualCheck(ComputeResidual(swappableBuffer.GetFront(), rightHandSide, alpha, beta, obstacleFaces), rightHandSide, alpha, system, iteration, false);
+			PollResidualChecks(system);
+
+			if (state.solveConverged)
+			{
+				break;
+			}
+		}
+	}
+
+	IssueResidualCheck(ComputeResidual(swappableBuffer.GetFront(), rightHandSide, alpha, beta, obstacleFaces), rightHandSide, alpha, system, iteration, true);
+}
+
+// omega != 1 runs chebyshev.frag, which reweights against x(k - 1). It is still in the back buffer and read from the render target itself.
+// The first Chebyshev sweep has omega = 1 and is plain Jacobi, the back buffer does not hold x(k - 1) yet.
+// The programs come from the variant caches, specialized on the obstacles, the scalar solve and the grid size where the pass reads them.
+void CStdGLFluidSolver::JacobiSweep(CStdSwappableFramebuffer &swappableBuffer, const CStdFramebuffer &rightHandSide, const float alpha, const float beta, const PoissonSystem system, const float omega)
+{
+	const bool obstacleFaces{system == PoissonSystem::Pressure && UsesObstacles()};
+	const CStdTexture &field{swappableBuffer.GetFront().GetTexture()};
+
+	if (vars.backend == SimulationBackend::Compute)
+	{
+		auto &[program, uniforms] = simulationJacobiVariants.Get({obstacleFaces, field.GetWidth(), field.GetHeight()});
+		program.Select();
+		uniforms.alpha.Set(alpha);
+		uniforms.beta.Set(beta);
+		uniforms.omega.Set(omega);
+		uniforms.obstacles.Set(obstacleFaces);
+		BindTexture(program, "field", field);
+		BindTexture(program, "b", rightHandSide.GetTexture());
+		if (obstacleFaces)
+		{
+			BindTexture(program, "obstacleField", obstacles->field.GetTexture());
+		}
+		BindTexture(program, "previous", swappableBuffer.GetBack().GetTexture());
+		swappableBuffer.GetBack().GetTexture().BindImage(0, GL_WRITE_ONLY);
+		DispatchSimulation();
+
+		swappableBuffer.SwapBuffers();
+		return;
+	}
+
+	const bool scalar{system == PoissonSystem::Pressure};
+	auto &[program, uniforms] = omega != 1.0f ? chebyshevVariants.Get({obstacleFaces}) : jacobiVariants.Get({obstacleFaces, scalar, field.GetWidth(), field.GetHeight()});
+
+	program.Select();
+	uniforms.alpha.Set(alpha);
+	uniforms.beta.Set(beta);
+	uniforms.obstacles.Set(obstacleFaces);
+	swappableBuffer.GetBack().Bind();
+	BindTexture(program, "x", field);
+	BindTexture(program, "b", rightHandSide.GetTexture());
+	if (obstacleFaces)
+	{
+		BindTexture(program, "obstacleField", obstacles->field.GetTexture());
+	}
+
+	if (omega != 1.0f)
+	{
+		uniforms.omega.Set(omega);
+		BindTexture(program, "previous", swappableBuffer.GetBack().GetTexture());
+		glTextureBarrier();
+	}
+	else
+	{
+		uniforms.scalar.Set(scalar);
+	}
+
+	DrawQuad();
+	swappableBuffer.SwapBuffers();
+}
+
+bool CStdGLFluidSolver::UsesFusedDivergence() const
+{
+	return vars.fusedPasses.divergence && !UsesSpectralProjection() && !UsesPackedPressure() && !UsesRefinement() && !UsesObstacles()
+		&& (vars.poissonSolver == PoissonSolver::Jacobi || vars.poissonSolver == PoissonSolver::Chebyshev);
+}
+
+// First pressure sweep of the fused divergence: computes div(velocity) per cell, stores it into divergence for the remaining sweeps
+// and uses it right away as the right hand side
+void CStdGLFluidSolver::DivergenceSweep(CStdSwappableFramebuffer &swappableBuffer, const CStdFramebuffer &divergence, const CStdFramebuffer &velocity, const float alpha, const float beta)
+{
+	if (vars.backend == SimulationBackend::Compute)
+	{
+		simulationDivergenceJacobiShaderProgram.Select();
+		simulationDivergenceJacobiShaderProgram.SetUniform("alpha", glUniform1f, alpha);
+		simulationDivergenceJacobiShaderProgram.SetUniform("beta", glUniform1f, beta);
+		BindTexture(simulationDivergenceJacobiShaderProgram, "field", swappableBuffer.GetFront().GetTexture());
+		BindTexture(simulationDivergenceJacobiShaderProgram, "velocity", velocity.GetTexture());
+		swappableBuffer.GetBack().GetTexture().BindImage(0, GL_WRITE_ONLY);
+		divergence.GetTexture().BindImage(1, GL_WRITE_ONLY);
+		DispatchSimulation();
+
+		swappableBuffer.SwapBuffers();
+		return;
+	}
+
+	swappableBuffer.GetBack().Bind();
+	divergenceJacobiShaderProgram.Select();
+	divergenceJacobiShaderProgram.SetUniform("alpha", glUniform1f, alpha);
+	divergenceJacobiShaderProgram.SetUniform("beta", glUniform1f, beta);
+	BindTexture(divergenceJacobiShaderProgram, "x", swappableBuffer.GetFront().GetTexture());
+	BindTexture(divergenceJacobiShaderProgram, "velocity", velocity.GetTexture());
+	divergence.GetTexture().BindImage(0, GL_WRITE_ONLY);
+	DrawQuad();
+	glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+
+	swappableBuffer.SwapBuffers();
+}
+
+bool CStdGLFluidSolver::UsesJacobiBlocking() const
+{
+	return vars.backend == SimulationBackend::Compute && vars.poissonSolver == PoissonSolver::Jacobi && vars.jacobiBlockSweeps > 1 && !UsesObstacles();
+}
+
+// sweeps <= jacobiBlockSweeps plain Jacobi sweeps in one dispatch of the temporally blocked kernel
+void CStdGLFluidSolver::JacobiBlock(CStdSwappableFramebuffer &swappableBuffer, const CStdFramebuffer &rightHandSide, const float alpha, const float beta, const std::size_t sweeps)
+{
+	simulationJacobiBlockedShaderProgram.Select();
+	simulationJacobiBlockedShaderProgram.SetUniform("alpha", glUniform1f, alpha);
+	simulationJacobiBlockedShaderProgram.SetUniform("beta", glUniform1f, beta);
+	simulationJacobiBlockedShaderProgram.SetUniform("sweeps", glUniform1i, static_cast<GLint>(sweeps));
+	BindTexture(simulationJacobiBlockedShaderProgram, "x", swappableBuffer.GetFront().GetTexture());
+	BindTexture(simulationJacobiBlockedShaderProgram, "b", rightHandSide.GetTexture());
+	swappableBuffer.GetBack().GetTexture().BindImage(0, GL_WRITE_ONLY);
+	DispatchSimulation();
+
+	swappableBuffer.SwapBuffers();
+}
+
+// residual.frag into residualBuffer, obstacleFaces adds the Neumann faces of the obstacles to the pressure stencil
+const CStdTexture &CStdGLFluidSolver::ComputeResidual(const CStdFramebuffer &field, const CStdFramebuffer &rightHandSide, const float alpha, const float beta, const bool obstacleFaces)
+{
+	residualBuffer.Bind();
+	residualShaderProgram.Select();
+	// The multigrid cycles set the stride of their level, 0 takes the texel size of the frame constants
+	residualShaderProgram.SetUniform("stride", glm::vec2{0.0f});
+	residualShaderProgram.SetUniform("alpha", glUniform1f, alpha);
+	residualShaderProgram.SetUniform("beta", glUniform1f, beta);
+	residualShaderProgram.SetUniform("obstacles", glUniform1i, obstacleFaces);
+	BindTexture(residualShaderProgram, "x", field.GetTexture());
+	BindTexture(residualShaderProgram, "b", rightHandSide.GetTexture());
+	if (obstacleFaces)
+	{
+		BindTexture(residualShaderProgram, "obstacleField", obstacles->field.GetTexture());
+	}
+	DrawQuad();
+
+	return residualBuffer.GetTexture();
+}
+
+// Two stage reduction of residual into a slot of the mapped results buffer.
+// If every slot is still waiting for its readback, the oldest check is waited for and consumed, so no check is lost.
+void CStdGLFluidSolver::IssueResidualCheck(const CStdTexture &residual, const CStdFramebuffer &rightHandSide, const float alpha, const PoissonSystem system, const std::size_t iteration, const bool final)
+{
+	const std::size_t slot{nextResidualSlot};
+	if (residualSlotBusy[slot])
+	{
+		// Slots are handed out in order, the oldest check is at the front of the queue of its system
+		for (std::size_t i{0}; i < convergence.size(); ++i)
+		{
+			const std::deque<ResidualCheck> &pending{convergence[i].pending};
+			if (!pending.empty() && pending.front().slot == slot)
+			{
+				pending.front().fence.Wait();
+				PollResidualChecks(static_cast<PoissonSystem>(i));
+			}
+		}
+	}
+
+	residualSlotBusy[slot] = true;
+	nextResidualSlot = (slot + 1) % NumResidualSlots;
+
+	ReduceResidualNorms(residual, rightHandSide, alpha, residualResults, static_cast<GLint>(slot));
+	glMemoryBarrier(GL_CLIENT_MAPPED_BUFFER_BARRIER_BIT);
+
+	ConvergenceState &state{convergence[static_cast<std::size_t>(system)]};
+	ResidualCheck &check{state.pending.emplace_back(ResidualCheck{CStdFence{}, slot, state.solve, iteration, final})};
+	check.fence.Insert();
+}
+
+// Consumes the checks whose fence has signaled, never waits
+void CStdGLFluidSolver::PollResidualChecks(const PoissonSystem system)
+{
+	ConvergenceState &state{convergence[static_cast<std::size_t>(system)]};
+
+	while (!state.pending.empty() && state.pending.front().fence.IsSignaled())
+	{
+		const ResidualCheck check{std::move(state.pending.front())};
+		state.pending.pop_front();
+		residualSlotBusy[check.slot] = false;
+
+		// x: sum of r^2, y: max |r|, z: sum of (alpha * b)^2
+		const glm::vec4 norms{residualResultsData[check.slot]};
+		const float residual{norms.z > 0.0f ? std::sqrt(norms.x / norms.z) : 0.0f};
+		const bool converged{residual <= (vars.poissonSolver == PoissonSolver::ConjugateGradient ? vars.pcgTolerance : vars.poissonTolerance)};
+
+		if (check.solve != state.readbackSolve)
+		{
+			state.readbackSolve = check.solve;
+			state.convergedIteration = 0;
+		}
+
+		if (converged && !state.convergedIteration)
+		{
+			state.convergedIteration = check.iteration;
+		}
+
+		if (converged && check.solve == state.solve)
+		{
+			state.solveConverged = true;
+		}
+
+		if (check.final)
+		{
+			poissonStatistics[static_cast<std::size_t>(system)] = PoissonStatistics{check.iteration, residual, norms.y};
+			state.iterationBudget = state.convergedIteration ? state.convergedIteration : check.iteration + check.iteration / 2 + vars.poissonCheckInterval;
+		}
+	}
+}
+
+// Stores (sum of r^2, max |r|, sum of (alpha * b)^2) of residual in the slot of results, see residual_norm.comp
+void CStdGLFluidSolver::ReduceResidualNorms(const CStdTexture &residual, const CStdFramebuffer &rightHandSide, const float alpha, const CStdBuffer &results, const GLint slot)
+{
+	residualPartials.BindBase(GL_SHADER_STORAGE_BUFFER, 0);
+	results.BindBase(GL_SHADER_STORAGE_BUFFER, 1);
+
+	residualNormReduceShaderProgram.Select();
+	residualNormReduceShaderProgram.SetUniform("alpha", glUniform1f, alpha);
+	BindTexture(residualNormReduceShaderProgram, "residual", residual);
+	BindTexture(residualNormReduceShaderProgram, "b", rightHandSide.GetTexture());
+	DispatchCompute();
+
+	residualNormFinishShaderProgram.Select();
+	residualNormFinishShaderProgram.SetUniform("count", glUniform1i, static_cast<GLint>(GetNumComputeGroups()));
+	residualNormFinishShaderProgram.SetUniform("slot", glUniform1i, slot);
+	glDispatchCompute(1, 1, 1);
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+// Updates field in place, it is bound as render target and sampler at the same time.
+// Each half sweep writes one color and reads only the other, glTextureBarrier makes the writes visible to the next one.
+// That needs even grid sizes, see UsesRedBlackSOR.
+void CStdGLFluidSolver::SolveRedBlackSOR(const CStdFramebuffer &field, const CStdFramebuffer &rightHandSide, const float alpha, const float beta, const std::size_t iterations)
+{
+	field.Bind();
+	sorShaderProgram.Select();
+	sorUniforms.alpha.Set(alpha);
+	sorUniforms.beta.Set(beta);
+	sorUniforms.omega.Set(vars.sorOmega);
+	BindTexture(sorShaderProgram, "x", field.GetTexture());
+	BindTexture(sorShaderProgram, "b", rightHandSide.GetTexture());
+
+	for (std::size_t i{0}; i < iterations; ++i)
+	{
+		for (GLint parity{0}; parity < 2; ++parity)
+		{
+			sorUniforms.parity.Set(parity);
+			DrawQuad();
+			glTextureBarrier();
+		}
+	}
+}
+
+bool CStdGLFluidSolver::UsesPackedPressure() const
+{
+	return vars.pressureLayout == PressureLayout::Packed && (vars.poissonSolver == PoissonSolver::Jacobi || vars.poissonSolver == PoissonSolver::Chebyshev) && width % 2 == 0 && height % 2 == 0;
+}
+
+// pack.frag the right hand side, run the sweeps on the half size grid with jacobi_packed.frag and unpack.frag the result into the field.
+// The sweep count is fixed, the residual is only checked once for the statistics.
+void CStdGLFluidSolver::SolvePacked(CStdSwappableFramebuffer &swappableBuffer, const CStdFramebuffer &rightHandSide, const float alpha, const float beta, const PoissonSystem system)
+{
+	EnsurePackedStorage(swappableBuffer.GetFront());
+	PackedStorage &storage{*packed};
+
+	ConvergenceState &state{convergence[static_cast<std::size_t>(system)]};
+	PollResidualChecks(system);
+	++state.solve;
+
+	CStdGLState::Viewport(0, 0, width / 2, height / 2);
+
+	storage.rightHandSide.Bind();
+	packShaderProgram.Select();
+	BindTexture(packShaderProgram, "field", rightHandSide.GetTexture());
+	DrawQuad();
+
+	jacobiPackedShaderProgram.Select();
+	jacobiPackedUniforms.alpha.Set(alpha);
+	jacobiPackedUniforms.beta.Set(beta);
+	BindTexture(jacobiPackedShaderProgram, "b", storage.rightHandSide.GetTexture());
+
+	// The bound is taken on the full size grid, packing does not change the operator
+	const bool chebyshev{vars.poissonSolver == PoissonSolver::Chebyshev};
+	CStdChebyshevWeights weights{beta, width, height, vars.poissonMaxIterations};
+
+	for (std::size_t i{0}; i < vars.poissonMaxIterations; ++i)
+	{
+		const float omega{chebyshev ? weights.Next() : 1.0f};
+
+		storage.solution.GetBack().Bind();
+		jacobiPackedUniforms.omega.Set(omega);
+		BindTexture(jacobiPackedShaderProgram, "x", storage.solution.GetFront().GetTexture());
+		// The render target stays bound as previous even for plain sweeps, the barrier keeps that defined
+		BindTexture(jacobiPackedShaderProgram, "previous", storage.solution.GetBack().GetTexture());
+		glTextureBarrier();
+
+		DrawQuad();
+		storage.solution.SwapBuffers();
+	}
+
+	CStdGLState::Viewport(0, 0, width, height);
+
+	swappableBuffer.GetFront().Bind();
+	unpackShaderProgram.Select();
+	BindTexture(unpackShaderProgram, "packed", storage.solution.GetFront().GetTexture());
+	DrawQuad();
+
+	IssueResidualCheck(ComputeResidual(swappableBuffer.GetFront(), rightHandSide, alpha, beta), rightHandSide, alpha, system, vars.poissonMaxIterations, true);
+}
+
+// A new packed solution starts from the current field
+void CStdGLFluidSolver::EnsurePackedStorage(const CStdFramebuffer &initialValue)
+{
+	const std::int32_t packedWidth{width / 2};
+	const std::int32_t packedHeight{height / 2};
+
+	if (packed && packed->rightHandSide.GetWidth() == packedWidth && packed->rightHandSide.GetHeight() == packedHeight)
+	{
+		return;
+	}
+
+	packed = std::make_unique<PackedStorage>(PackedStorage{
+		CStdSwappableFramebuffer{packedWidth, packedHeight, GL_RGBA32F, GL_RGBA},
+		CStdFramebuffer{packedWidth, packedHeight, GL_RGBA32F, GL_RGBA}
+	});
+
+	CStdGLState::Viewport(0, 0, packedWidth, packedHeight);
+	packed->solution.GetFront().Bind();
+	packShaderProgram.Select();
+	BindTexture(packShaderProgram, "field", initialValue.GetTexture());
+	DrawQuad();
+	CStdGLState::Viewport(0, 0, width, height);
+}
+
+bool CStdGLFluidSolver::UsesRefinement() const
+{
+	return vars.refinementPasses > 0 && (vars.poissonSolver == PoissonSolver::Jacobi || vars.poissonSolver == PoissonSolver::Chebyshev || vars.poissonSolver == PoissonSolver::RedBlackSOR);
+}
+
+// Iterative refinement: the solution and the residual alpha * b - A * x are fp32, only the correction A * e = r is solved
+// with sweeps in the pressure format. The residual is normalized by its largest entry on the GPU, so no pass needs a read back.
+// Unlike SolveJacobi the sweep count is fixed, the tolerance is not used.
+void CStdGLFluidSolver::SolveRefined(CStdSwappableFramebuffer &swappableBuffer, const CStdFramebuffer &rightHandSide, const float alpha, const float beta, const PoissonSystem system)
+{
+	EnsureRefinementStorage(swappableBuffer.GetFront());
+	RefinementStorage &storage{*refinement};
+
+	ConvergenceState &state{convergence[static_cast<std::size_t>(system)]};
+	PollResidualChecks(system);
+	++state.solve;
+
+	const bool chebyshev{vars.poissonSolver == PoissonSolver::Chebyshev};
+
+	// r = alpha * b - A * x in fp32
+	const auto computeResidual = [&]
+	{
+		refinementResidualShaderProgram.Select();
+		refinementResidualShaderProgram.SetUniform("alpha", glUniform1f, alpha);
+		refinementResidualShaderProgram.SetUniform("beta", glUniform1f, beta);
+		storage.solution.BindImage(0, GL_READ_ONLY);
+		BindTexture(refinementResidualShaderProgram, "rightHandSide", rightHandSide.GetTexture());
+		storage.residual.BindImage(2, GL_WRITE_ONLY);
+		DispatchCompute();
+		glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+	};
+
+	// Scaled residual, the right hand side of the correction solves
+	const CStdRenderTargetPool::Lease scaledResidual{targetPool.Acquire(CStdRenderTargetPool::GetDesc(rightHandSide))};
+
+	for (std::size_t pass{0}; pass < vars.refinementPasses; ++pass)
+	{
+		computeResidual();
+		ReduceResidualNorms(storage.residual, rightHandSide, alpha, storage.norms, 0);
+
+		storage.norms.BindBase(GL_SHADER_STORAGE_BUFFER, 0);
+		refinementScaleShaderProgram.Select();
+		storage.residual.BindImage(0, GL_READ_ONLY);
+		scaledResidual.Get().GetTexture().BindImage(1, GL_WRITE_ONLY);
+		swappableBuffer.GetFront().GetTexture().BindImage(2, GL_WRITE_ONLY);
+		DispatchCompute();
+		glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT);
+
+		// A * e = r / max |r|, the scaling is already in the right hand side
+		if (UsesRedBlackSOR())
+		{
+			SolveRedBlackSOR(swappableBuffer.GetFront(), scaledResidual.Get(), 1.0f, beta, vars.refinementSweeps);
+		}
+		else
+		{
+			CStdChebyshevWeights weights{beta, width, height, vars.refinementSweeps};
+			for (std::size_t i{0}; i < vars.refinementSweeps; ++i)
+			{
+				JacobiSweep(swappableBuffer, scaledResidual.Get(), 1.0f, beta, system, chebyshev ? weights.Next() : 1.0f);
+			}
+		}
+
+		storage.norms.BindBase(GL_SHADER_STORAGE_BUFFER, 0);
+		refinementCorrectShaderProgram.Select();
+		storage.solution.BindImage(0, GL_READ_WRITE);
+		swappableBuffer.GetFront().GetTexture().BindImage(1, GL_READ_WRITE);
+		DispatchCompute();
+	}
+
+	computeResidual();
+	IssueResidualCheck(storage.residual, rightHandSide, alpha, system, vars.refinementPasses * vars.refinementSweeps, true);
+	glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT);
+}
+
+// A new fp32 solution starts from the current pressure field
+void CStdGLFluidSolver::EnsureRefinementStorage(const CStdFramebuffer &initialValue)
+{
+	if (refinement && refinement->solution.GetWidth() == width && refinement->solution.GetHeight() == height)
+	{
+		return;
+	}
+
+	refinement = std::make_unique<RefinementStorage>(RefinementStorage{
+		CStdTexture{width, height, GL_RG32F, GL_RG, GL_FLOAT},
+		CStdTexture{width, height, GL_RG32F, GL_RG, GL_FLOAT},
+		CStdBuffer{static_cast<GLsizeiptr>(sizeof(glm::vec4))}
+	});
+
+	refinementInitShaderProgram.Select();
+	BindTexture(refinementInitShaderProgram, "initialValue", initialValue.GetTexture());
+	refinement->solution.BindImage(1, GL_WRITE_ONLY);
+	DispatchCompute();
+}
+
+void CStdGLFluidSolver::SolveMultigrid(CStdSwappableFramebuffer &solution, const CStdFramebuffer &rightHandSide, const float alpha, const float beta, const PoissonSystem system)
+{
+	MultigridHierarchy &hierarchy{multigrid[static_cast<std::size_t>(system)]};
+	EnsureMultigridLevels(hierarchy, solution.GetFront().GetTexture());
+	std::vector<MultigridLevel> &levels{hierarchy.levels};
+
+	levels[0].solution = &solution;
+	levels[0].rightHandSide = &rightHandSide;
+	levels[0].alpha = alpha;
+	levels[0].beta = beta;
+
+	for (std::size_t i{1}; i < levels.size(); ++i)
+	{
+		levels[i].alpha = 4.0f;
+		levels[i].beta = 4.0f + 4.0f * (levels[i - 1].beta - 4.0f);
+	}
+
+	for (std::size_t i{0}; i < vars.multigridCycles; ++i)
+	{
+		RunMultigridCycle(hierarchy, 0, vars.multigridCycle);
+	}
+
+	// The cycles leave the stride of the last level they ran in the programs, the full size passes expect none
+	smoothShaderProgram.Select();
+	smoothShaderProgram.SetUniform("stride", glm::vec2{0.0f});
+	residualShaderProgram.Select();
+	residualShaderProgram.SetUniform("stride", glm::vec2{0.0f});
+
+	CStdGLState::Viewport(0, 0, width, height);
+}
+
+// The levels take the format of field, an fp32 pressure keeps its coarse corrections in fp32 as well.
+// Every level halves the grid while both sizes are even, a coarse cell then covers exactly 2x2 fine cells and the periodic wrap of both lines up.
+// An odd size ends the hierarchy: (n + 1) / 2 coarse cells would not tile n fine ones, the bilinear restriction and prolongation would
+// sample between the fine cells and the last coarse cell would straddle the wrap. Grids with few factors of two get a shallow hierarchy,
+// their coarsest level is smoothed CoarsestSmoothingSteps times like any other.
+void CStdGLFluidSolver::EnsureMultigridLevels(MultigridHierarchy &hierarchy, const CStdTexture &field)
+{
+	const GLenum internalFormat{field.GetInternalFormat()};
+	const GLenum format{field.GetFormat()};
+
+	if (!hierarchy.levels.empty())
+	{
+		const CStdTexture &finest{hierarchy.levels[0].residual.GetTexture()};
+		if (finest.GetWidth() == width && finest.GetHeight() == height && finest.GetInternalFormat() == internalFormat)
+		{
+			return;
+		}
+	}
+
+	hierarchy.levels.clear();
+	hierarchy.storage.clear();
+
+	std::int32_t levelWidth{width};
+	std::int32_t levelHeight{height};
+	hierarchy.levels.push_back({nullptr, nullptr, CStdFramebuffer{levelWidth, levelHeight, internalFormat, format}, 0.0f, 0.0f});
+
+	while (levelWidth % 2 == 0 && levelHeight % 2 == 0 && std::min(levelWidth, levelHeight) / 2 >= MinimumMultigridLevelSize)
+	{
+		levelWidth /= 2;
+		levelHeight /= 2;
+
+		auto &coarse = *hierarchy.storage.emplace_back(std::make_unique<MultigridStorage>(MultigridStorage{
+			{levelWidth, levelHeight, internalFormat, format},
+			{levelWidth, levelHeight, internalFormat, format}
+		}));
+		hierarchy.levels.push_back({&coarse.solution, &coarse.rightHandSide, CStdFramebuffer{levelWidth, levelHeight, internalFormat, format}, 0.0f, 0.0f});
+	}
+}
+
+void CStdGLFluidSolver::RunMultigridCycle(MultigridHierarchy &hierarchy, const std::size_t index, const MultigridCycle cycle)
+{
+	MultigridLevel &level{hierarchy.levels[index]};
+
+	if (index + 1 == hierarchy.levels.size())
+	{
+		Smooth(level, CoarsestSmoothingSteps);
+		return;
+	}
+
+	Smooth(level, vars.multigridSmoothingSteps);
+
+	const std::int32_t levelWidth{level.residual.GetWidth()};
+	const std::int32_t levelHeight{level.residual.GetHeight()};
+
+	// r = alpha * b - A * x
+	level.residual.Bind();
+	residualShaderProgram.Select();
+	residualShaderProgram.SetUniform("stride", glm::vec2{1.0f / levelWidth, 1.0f / levelHeight});
+	residualShaderProgram.SetUniform("alpha", glUniform1f, level.alpha);
+	residualShaderProgram.SetUniform("beta", glUniform1f, level.beta);
+	residualShaderProgram.SetUniform("obstacles", glUniform1i, 0);
+	BindTexture(residualShaderProgram, "x", level.solution->GetFront().GetTexture());
+	BindTexture(residualShaderProgram, "b", level.rightHandSide->GetTexture());
+	DrawQuad();
+
+	// Restriction, the bilinear copy into the half size target averages 2x2 cells
+	MultigridLevel &coarse{hierarchy.levels[index + 1]};
+	CStdGLState::Viewport(0, 0, coarse.residual.GetWidth(), coarse.residual.GetHeight());
+	CopyBuffers(level.residual, hierarchy.storage[index]->rightHandSide);
+	coarse.solution->GetFront().Clear();
+
+	if (cycle == MultigridCycle::F)
+	{
+		RunMultigridCycle(hierarchy, index + 1, MultigridCycle::F);
+	}
+	RunMultigridCycle(hierarchy, index + 1, MultigridCycle::V);
+
+	// Prolongation, x += interpolated coarse correction
+	CStdGLState::Viewport(0, 0, levelWidth, levelHeight);
+	level.solution->GetBack().Bind();
+	prolongateShaderProgram.Select();
+	BindTexture(prolongateShaderProgram, "field", level.solution->GetFront().GetTexture());
+	BindTexture(prolongateShaderProgram, "correction", coarse.solution->GetFront().GetTexture());
+	DrawQuad();
+	level.solution->SwapBuffers();
+
+	Smooth(level, vars.multigridSmoothingSteps);
+}
+
+void CStdGLFluidSolver::Smooth(MultigridLevel &level, const std::size_t steps)
+{
+	const std::int32_t levelWidth{level.residual.GetWidth()};
+	const std::int32_t levelHeight{level.residual.GetHeight()};
+
+	CStdGLState::Viewport(0, 0, levelWidth, levelHeight);
+	smoothShaderProgram.Select();
+	smoothShaderProgram.SetUniform("stride", glm::vec2{1.0f / levelWidth, 1.0f / levelHeight});
+	smoothShaderProgram.SetUniform("alpha", glUniform1f, level.alpha);
+	smoothShaderProgram.SetUniform("beta", glUniform1f, level.beta);
+	smoothShaderProgram.SetUniform("omega", glUniform1f, SmoothingWeight);
+	BindTexture(smoothShaderProgram, "b", level.rightHandSide->GetTexture());
+
+	for (std::size_t i{0}; i < steps; ++i)
+	{
+		level.solution->GetBack().Bind();
+		BindTexture(smoothShaderProgram, "x", level.solution->GetFront().GetTexture());
+		DrawQuad();
+		level.solution->SwapBuffers();
+	}
+}
+
+// Every CG scalar is computed and consumed on the GPU. Every pcgCheckInterval iterations the residual norm is sent back
+// through IssueResidualCheck without waiting for it, a result that is already back ends the solve once it is below pcgTolerance.
+void CStdGLFluidSolver::SolveConjugateGradient(const CStdFramebuffer &field, const CStdFramebuffer &rightHandSide, const float alpha, const float beta, const PoissonSystem system)
+{
+	ConvergenceState &state{convergence[static_cast<std::size_t>(system)]};
+	PollResidualChecks(system);
+	++state.solve;
+	state.solveConverged = false;
+
+	EnsureConjugateGradientStorage();
+	ConjugateGradientStorage &storage{*conjugateGradient};
+
+	storage.partials.BindBase(GL_SHADER_STORAGE_BUFFER, 0);
+	storage.scalars.BindBase(GL_SHADER_STORAGE_BUFFER, 1);
+
+	// x = x0, r = alpha * b - A * x0
+	pcgInitShaderProgram.Select();
+	pcgInitShaderProgram.SetUniform("alpha", glUniform1f, alpha);
+	pcgInitShaderProgram.SetUniform("beta", glUniform1f, beta);
+	BindTexture(pcgInitShaderProgram, "initialValue", field.GetTexture());
+	BindTexture(pcgInitShaderProgram, "rightHandSide", rightHandSide.GetTexture());
+	storage.solution.BindImage(2, GL_WRITE_ONLY);
+	storage.residual.BindImage(3, GL_WRITE_ONLY);
+	DispatchCompute();
+
+	// The pure Neumann pressure system is singular, keep r orthogonal to its null space
+	if (beta <= 4.0f)
+	{
+		Reduce(storage.residual, storage.residual, SumSlot, true);
+
+		pcgCenterShaderProgram.Select();
+		pcgCenterShaderProgram.SetUniform("slot", glUniform1i, SumSlot);
+		storage.residual.BindImage(0, GL_READ_WRITE);
+		DispatchCompute();
+	}
+
+	Precondition(beta);
+
+	pcgDirectionShaderProgram.Select();
+	pcgDirectionShaderProgram.SetUniform("restart", glUniform1i, GL_TRUE);
+	storage.direction.BindImage(0, GL_READ_WRITE);
+	storage.preconditioned.BindImage(1, GL_READ_ONLY);
+	DispatchCompute();
+
+	GLint rzSlot{RZSlot};
+	GLint rzNewSlot{RZNewSlot};
+	Reduce(storage.residual, storage.preconditioned, rzSlot);
+
+	std::size_t iteration{0};
+	while (iteration < vars.pcgMaxIterations)
+	{
+		// q = A * p
+		pcgApplyShaderProgram.Select();
+		pcgApplyShaderProgram.SetUniform("beta", glUniform1f, beta);
+		storage.direction.BindImage(0, GL_READ_ONLY);
+		storage.product.BindImage(1, GL_WRITE_ONLY);
+		DispatchCompute();
+
+		Reduce(storage.direction, storage.product, ProductSlot);
+
+		pcgStepShaderProgram.Select();
+		pcgStepShaderProgram.SetUniform("rzSlot", glUniform1i, rzSlot);
+		pcgStepShaderProgram.SetUniform("pqSlot", glUniform1i, ProductSlot);
+		storage.solution.BindImage(0, GL_READ_WRITE);
+		storage.residual.BindImage(1, GL_READ_WRITE);
+		storage.direction.BindImage(2, GL_READ_ONLY);
+		storage.product.BindImage(3, GL_READ_ONLY);
+		DispatchCompute();
+
+		Precondition(beta);
+		Reduce(storage.residual, storage.preconditioned, rzNewSlot);
+
+		pcgDirectionShaderProgram.Select();
+		pcgDirectionShaderProgram.SetUniform("restart", glUniform1i, GL_FALSE);
+		pcgDirectionShaderProgram.SetUniform("rzSlot", glUniform1i, rzSlot);
+		pcgDirectionShaderProgram.SetUniform("rzNewSlot", glUniform1i, rzNewSlot);
+		storage.direction.BindImage(0, GL_READ_WRITE);
+		storage.preconditioned.BindImage(1, GL_READ_ONLY);
+		DispatchCompute();
+
+		std::swap(rzSlot, rzNewSlot);
+		++iteration;
+
+		if (iteration % vars.pcgCheckInterval == 0 && iteration < vars.pcgMaxIterations)
+		{
+			// The norms sample r, it was written as an image
+			glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+			IssueResidualCheck(storage.residual, rightHandSide, alpha, system, iteration, false);
+			PollResidualChecks(system);
+
+			if (state.solveConverged)
+			{
+				break;
+			}
+		}
+	}
+
+	pcgStoreShaderProgram.Select();
+	storage.solution.BindImage(0, GL_READ_ONLY);
+	field.GetTexture().BindImage(1, GL_WRITE_ONLY);
+	DispatchCompute();
+	glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT);
+
+	IssueResidualCheck(ComputeResidual(field, rightHandSide, alpha, beta), rightHandSide, alpha, system, iteration, true);
+}
+
+void CStdGLFluidSolver::EnsureConjugateGradientStorage()
+{
+	if (conjugateGradient && conjugateGradient->solution.GetWidth() == width && conjugateGradient->solution.GetHeight() == height)
+	{
+		return;
+	}
+
+	const auto newTexture = [this] { return CStdTexture{width, height, GL_RG32F, GL_RG, GL_FLOAT}; };
+
+	conjugateGradient = std::make_unique<ConjugateGradientStorage>(ConjugateGradientStorage{
+		newTexture(), newTexture(), newTexture(), newTexture(), newTexture(),
+		CStdBuffer{GetNumComputeGroups() * static_cast<GLsizeiptr>(sizeof(glm::vec2))},
+		CStdBuffer{NumConjugateGradientSlots * static_cast<GLsizeiptr>(sizeof(glm::vec2))}
+	});
+}
+
+// One invocation per cell, the barrier makes image and buffer writes visible to the next kernel
+void CStdGLFluidSolver::DispatchCompute()
+{
+	glDispatchCompute(GetNumComputeGroupsX(), GetNumComputeGroupsY(), 1);
+	glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+	++passCount;
+}
+
+// Simulation kernels are read back through samplers and render targets as well, by the renderer and the fragment passes of the Poisson solvers
+void CStdGLFluidSolver::DispatchSimulation()
+{
+	glDispatchCompute(GetNumComputeGroupsX(), GetNumComputeGroupsY(), 1);
+	glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT);
+	++passCount;
+}
+
+// Stores sum(lhs * rhs), or sum(lhs) with sum set, per channel in the scalars slot
+void CStdGLFluidSolver::Reduce(const CStdTexture &lhs, const CStdTexture &rhs, const GLint slot, const bool sum)
+{
+	pcgReduceShaderProgram.Select();
+	pcgReduceShaderProgram.SetUniform("sum", glUniform1i, sum);
+	lhs.BindImage(0, GL_READ_ONLY);
+	rhs.BindImage(1, GL_READ_ONLY);
+	DispatchCompute();
+
+	pcgFinishReductionShaderProgram.Select();
+	pcgFinishReductionShaderProgram.SetUniform("count", glUniform1i, static_cast<GLint>(GetNumComputeGroups()));
+	pcgFinishReductionShaderProgram.SetUniform("slot", glUniform1i, slot);
+	glDispatchCompute(1, 1, 1);
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+// z = K * K^T * r, the product texture holds the intermediate K^T * r
+void CStdGLFluidSolver::Precondition(const float beta)
+{
+	ConjugateGradientStorage &storage{*conjugateGradient};
+
+	pcgPreconditionShaderProgram.Select();
+	pcgPreconditionShaderProgram.SetUniform("beta", glUniform1f, beta);
+
+	pcgPreconditionShaderProgram.SetUniform("offset", glUniform1i, 1);
+	storage.residual.BindImage(0, GL_READ_ONLY);
+	storage.product.BindImage(1, GL_WRITE_ONLY);
+	DispatchCompute();
+
+	pcgPreconditionShaderProgram.SetUniform("offset", glUniform1i, -1);
+	storage.product.BindImage(0, GL_READ_ONLY);
+	storage.preconditioned.BindImage(1, GL_WRITE_ONLY);
+	DispatchCompute();
+}
+
+// Forward Hartley transform along rows and columns, division by the eigenvalues of the periodic operator fused into the column pass,
+// then the inverse transform in reverse order. Only the first channel is solved.
+void CStdGLFluidSolver::SolveSpectral(const CStdFramebuffer &field, const CStdFramebuffer &rightHandSide, const float alpha, const float beta)
+{
+	EnsureSpectralStorage();
+	SpectralStorage &storage{*spectral};
+
+	storage.columnTransformShaderProgram.Select();
+	storage.columnTransformShaderProgram.SetUniform("alpha", glUniform1f, alpha);
+	storage.columnTransformShaderProgram.SetUniform("beta", glUniform1f, beta);
+
+	TransformLines(storage.rowTransformShaderProgram, rightHandSide.GetTexture(), storage.spectrum, false, false, false);
+	TransformLines(storage.columnTransformShaderProgram, storage.spectrum, storage.temporary, true, false, true);
+	TransformLines(storage.columnTransformShaderProgram, storage.temporary, storage.spectrum, true, true, false);
+	TransformLines(storage.rowTransformShaderProgram, storage.spectrum, storage.temporary, false, true, false);
+
+	spectralStoreShaderProgram.Select();
+	BindTexture(spectralStoreShaderProgram, "solution", storage.temporary);
+	field.GetTexture().BindImage(0, GL_WRITE_ONLY);
+	glDispatchCompute(GetNumComputeGroupsX(), GetNumComputeGroupsY(), 1);
+	glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT);
+}
+
+std::size_t CStdGLFluidSolver::GetSpectralSharedMemorySize(const std::int32_t length)
+{
+	std::size_t paddedLength{1};
+	while (paddedLength < 2 * static_cast<std::size_t>(length) - 1)
+	{
+		paddedLength <<= 1;
+	}
+
+	return paddedLength * sizeof(glm::vec2);
+}
+
+bool CStdGLFluidSolver::UsesSpectralProjection() const
+{
+	return vars.projection == ProjectionMethod::Spectral && GetSpectralSharedMemorySize(std::max(width, height)) <= static_cast<std::size_t>(maxComputeSharedMemorySize);
+}
+
+void CStdGLFluidSolver::EnsureSpectralStorage()
+{
+	if (spectral && spectral->spectrum.GetWidth() == width && spectral->spectrum.GetHeight() == height)
+	{
+		return;
+	}
+
+	spectral = std::make_unique<SpectralStorage>();
+	spectral->spectrum = CStdTexture{width, height, GL_R32F, GL_RED, GL_FLOAT};
+	spectral->temporary = CStdTexture{width, height, GL_R32F, GL_RED, GL_FLOAT};
+
+	const auto prepare = [this](const std::int32_t length, CStdBuffer &chirp, CStdBuffer &chirpSpectrum, CStdGLShaderProgram &shaderProgram, std::string_view objectLabel)
+	{
+		const CStdFFT fft{static_cast<std::size_t>(length)};
+		chirp = CStdBuffer{static_cast<GLsizeiptr>(fft.GetChirp().size() * sizeof(CStdFFT::Complex)), 0, fft.GetChirp().data()};
+		chirpSpectrum = CStdBuffer{static_cast<GLsizeiptr>(fft.GetChirpSpectrum().size() * sizeof(CStdFFT::Complex)), 0, fft.GetChirpSpectrum().data()};
+
+		std::uint32_t bits{0};
+		while ((std::size_t{1} << bits) < fft.GetPaddedLength())
+		{
+			++bits;
+		}
+
+		CStdGLShader shader{CStdShader::Type::Compute, spectralSource};
+		shader.SetMacro("SPECTRAL_TRANSFORM", "1");
+		shader.SetMacro("FFT_SIZE", std::to_string(fft.GetPaddedLength()));
+		shader.SetMacro("FFT_BITS", std::to_string(bits) + "u");
+		shader.Compile();
+
+		shaderProgram.AddShader(&shader);
+		shaderProgram.Link();
+		shaderProgram.SetObjectLabel(objectLabel);
+	};
+
+	prepare(width, spectral->rowChirp, spectral->rowChirpSpectrum, spectral->rowTransformShaderProgram, "SPECTRAL_TRANSFORM rows");
+	prepare(height, spectral->columnChirp, spectral->columnChirpSpectrum, spectral->columnTransformShaderProgram, "SPECTRAL_TRANSFORM columns");
+}
+
+// One workgroup per line of source
+void CStdGLFluidSolver::TransformLines(CStdGLShaderProgram &program, const CStdTexture &source, const CStdTexture &destination, const bool columns, const bool inverse, const bool solve)
+{
+	SpectralStorage &storage{*spectral};
+
+	program.Select();
+	program.SetUniform("columns", glUniform1i, columns);
+	program.SetUniform("inverse", glUniform1i, inverse);
+	program.SetUniform("solve", glUniform1i, solve);
+	BindTexture(program, "field", source);
+	destination.BindImage(0, GL_WRITE_ONLY);
+	(columns ? storage.columnChirp : storage.rowChirp).BindBase(GL_SHADER_STORAGE_BUFFER, 0);
+	(columns ? storage.columnChirpSpectrum : storage.rowChirpSpectrum).BindBase(GL_SHADER_STORAGE_BUFFER, 1);
+
+	glDispatchCompute(columns ? width : height, 1, 1);
+	glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+}
+
+void CStdGLFluidSolver::ResizeFramebuffer(CStdFramebuffer &frameBuffer, std::int32_t newWidth, std::int32_t newHeight)
+{
+	const CStdTexture &texture{frameBuffer.GetTexture()};
+	CStdFramebuffer newFrameBuffer{newWidth, newHeight, texture.GetInternalFormat(), texture.GetFormat()};
+
+	CopyBuffers(frameBuffer, newFrameBuffer);
+	frameBuffer = std::move(newFrameBuffer);
+}
+
+void CStdGLFluidSolver::ResizeFramebuffer(CStdSwappableFramebuffer &swappableBuffer, std::int32_t newWidth, std::int32_t newHeight)
+{
+	const CStdTexture &texture{swappableBuffer.GetFront().GetTexture()};
+	CStdSwappableFramebuffer newSwappableBuffer{newWidth, newHeight, texture.GetInternalFormat(), texture.GetFormat()};
+
+	CopyBuffers(swappableBuffer.GetFront(), newSwappableBuffer.GetFront());
+	CopyBuffers(swappableBuffer.GetBack(), newSwappableBuffer.GetBack());
+
+	swappableBuffer = std::move(newSwappableBuffer);
+}
@@ -0,0 +1,395 @@
+#pragma once
+
+#include <array>
+#include <deque>
+#include <memory>
+
+#include "FluidSolver.h"
+#include "FrameGraph.h"
+#include "ObstacleMask.h"
+#include "Shader.h"
+#include "ShaderVariants.h"
+
+class CStdLine : public CStdVAOObject<CStdLine>
+{
+public:
+	static constexpr inline auto Dimensions = 3;
+	static constexpr inline auto PrimitiveType = GL_LINES;
+
+public:
+	CStdLine(const glm::vec2 &start, const glm::vec2 &end) : CStdVAOObject{}, start{start}, end{end} { Init(); }
+
+protected:
+	virtual void GenerateGeometry(std::vector<GLfloat> &vertices, std::vector<GLuint> &elements, std::vector<GLfloat> &normals, std::vector<GLfloat> &textureCoordinates) override
+	{
+		vertices = {start.x, start.y, 0, end.x, end.y, 0};
+		elements = {0, 1};
+	}
+
+private:
+	glm::vec2 start;
+	glm::vec2 end;
+};
+
+// GL implementation of the fluid solver. With the fragment backend every pass is a full-screen quad draw,
+// the compute backend dispatches the same passes from simulation.comp on the same framebuffers.
+class CStdGLFluidSolver : public CStdFluidSolver
+{
+	struct Border
+	{
+		CStdLine top;
+		CStdLine left;
+		CStdLine bottom;
+		CStdLine right;
+	};
+
+	// See CStdMultigridSolver for the level equations, level 0 points at the caller's buffers
+	struct MultigridLevel
+	{
+		CStdSwappableFramebuffer *solution;
+		const CStdFramebuffer *rightHandSide;
+		CStdFramebuffer residual;
+		float alpha;
+		float beta;
+	};
+
+	struct MultigridStorage
+	{
+		CStdSwappableFramebuffer solution;
+		CStdFramebuffer rightHandSide;
+	};
+
+	// Levels of one Poisson system, every level has the format of the field it solves for
+	struct MultigridHierarchy
+	{
+		std::vector<MultigridLevel> levels;
+		std::vector<std::unique_ptr<MultigridStorage>> storage;
+	};
+
+	// Indices into the PCG scalars buffer, the (r, z) slots alternate between iterations
+	enum ConjugateGradientSlot : GLint
+	{
+		SumSlot,
+		ProductSlot,
+		RZSlot,
+		RZNewSlot,
+		NumConjugateGradientSlots
+	};
+
+	// fp32 CG vectors, the fp16 framebuffers lose too much precision for the dot products
+	struct ConjugateGradientStorage
+	{
+		CStdTexture solution;
+		CStdTexture residual;
+		CStdTexture preconditioned;
+		CStdTexture direction;
+		CStdTexture product;
+		CStdBuffer partials;
+		CStdBuffer scalars;
+	};
+
+	// Residual norms of one solve that are still on their way back, see PollResidualChecks
+	struct ResidualCheck
+	{
+		CStdFence fence;
+		std::size_t slot;
+		std::size_t solve;
+		std::size_t iteration;
+		bool final;
+	};
+
+	struct ConvergenceState
+	{
+		std::size_t solve{0};
+		// Iterations the next solve runs with a tolerance set, learned from the finished solves
+		std::size_t iterationBudget{0};
+		std::deque<ResidualCheck> pending;
+		std::size_t readbackSolve{0};
+		std::size_t convergedIteration{0};
+		bool solveConverged{false};
+	};
+
+	// The FFT length is compiled into the transform programs, so they are rebuilt together with the tables on resize
+	struct SpectralStorage
+	{
+		CStdTexture spectrum;
+		CStdTexture temporary;
+		CStdBuffer rowChirp;
+		CStdBuffer rowChirpSpectrum;
+		CStdBuffer columnChirp;
+		CStdBuffer columnChirpSpectrum;
+		CStdGLShaderProgram rowTransformShaderProgram;
+		CStdGLShaderProgram columnTransformShaderProgram;
+	};
+
+	// fp32 side of the mixed precision pressure solve, the solution persists as warm start for the next step
+	struct RefinementStorage
+	{
+		CStdTexture solution;
+		CStdTexture residual;
+		CStdBuffer norms;
+	};
+
+	// Solid cells inside the domain. The obstacle field is rebuilt by jump flooding whenever the mask changed or moved, see obstacles.comp
+	struct ObstacleStorage
+	{
+		// As loaded, resampled to the grid on resize
+		CStdObstacleMask source;
+		CStdTexture mask;
+		std::array<CStdTexture, 2> seeds;
+		CStdFramebuffer field;
+		// Accumulated motion in cells, wrapped to the grid size
+		glm::vec2 position{0.0f, 0.0f};
+		glm::ivec2 offset{0, 0};
+		bool dirty{true};
+	};
+
+	// Pressure in the pack.frag layout, the solution persists as warm start for the next step
+	struct PackedStorage
+	{
+		CStdSwappableFramebuffer solution;
+		CStdFramebuffer rightHandSide;
+	};
+
+	// Uniforms that change every sweep of the iterative solvers, resolved once after linking
+	struct SweepUniforms
+	{
+		CStdUniformHandle<float> alpha;
+		CStdUniformHandle<float> beta;
+		CStdUniformHandle<float> omega;
+		CStdUniformHandle<bool> obstacles;
+		CStdUniformHandle<bool> scalar;
+		CStdUniformHandle<GLint> parity;
+
+		SweepUniforms() = default;
+		explicit SweepUniforms(const CStdGLShaderProgram &program);
+	};
+
+	using SweepVariants = CStdShaderVariants<SweepUniforms>;
+
+public:
+	// GL side of a FieldFormat
+	struct FieldFormatInfo
+	{
+		GLenum internalFormat;
+		GLenum format;
+		// Layout qualifier of the image variables that load from the field
+		const char *imageFormat;
+		const char *name;
+		std::size_t bytesPerTexel;
+	};
+
+	// std140 mirror of the FrameConstants block in frame_constants.glsl, uploaded once per Step
+	struct FrameConstants
+	{
+		glm::vec2 texelSize;
+		float gs;
+		float delta_t;
+		float dissipation;
+		float splatRadius;
+		float vorticityScale;
+		float padding;
+	};
+
+	static_assert(sizeof(FrameConstants) == 32, "FrameConstants has to match the std140 layout of the block");
+
+	// Footprint of one simulation field, bytesPerPass is the traffic of one full-field read or write of one of its buffers
+	struct FieldMemory
+	{
+		const char *name;
+		FieldFormat format;
+		std::size_t buffers;
+		std::size_t bytes;
+		std::size_t bytesPerPass;
+	};
+
+public:
+	CStdGLFluidSolver(const Variables &vars, std::int32_t width, std::int32_t height);
+
+public:
+	void LoadShaders();
+	// Polls the links LoadShaders started, Step needs FinishLoadingShaders first
+	bool AreShadersReady() const;
+	void FinishLoadingShaders();
+	void Step(float dt, const ImpulseState &impulseState) override;
+	void Resize(std::int32_t newWidth, std::int32_t newHeight) override;
+	std::vector<glm::vec2> GetVelocity() const override;
+
+	const CStdFramebuffer &GetVelocityBuffer() const { return velocityBuffer.GetFront(); }
+	// The persistent fields plus one entry per target of the pool as of the last Step, the solver specific storage is not included
+	std::vector<FieldMemory> GetFieldMemory() const;
+	// Passes of the last Step and where their transient fields went
+	const CStdFrameGraph &GetFrameGraph() const { return frameGraph; }
+	static FieldFormatInfo GetFieldFormatInfo(FieldFormat format);
+	// Full-field draws and dispatches of the last Step, the boundary lines count as one pass
+	std::size_t GetPassCount() const { return passCount; }
+
+	// Replaces the obstacles, the obstacle field is rebuilt at the next Step. Cheap enough to be called every frame.
+	void SetObstacleMask(const CStdObstacleMask &mask);
+	// Bit mask and signed distance of obstacles.glsl, nullptr without obstacles
+	const CStdFramebuffer *GetObstacleField() const { return obstacles ? &obstacles->field : nullptr; }
+
+	void CopyBuffers(const CStdFramebuffer &source, const CStdFramebuffer &destination);
+	void DrawQuad();
+	static void BindTexture(const CStdGLShaderProgram &program, std::string_view key, const CStdTexture &texture);
+
+	// Variant selection of the stencil passes (jacobi, divergence, gradient, vorticity).
+	// Auto and unsupported Gather requests fall back to TexelFetch, which every GL 3.0 driver has.
+	static bool SupportsGather();
+	static StencilFetch ResolveStencilFetch(StencilFetch requested);
+	static void SetStencilFetch(CStdGLShader &shader, StencilFetch fetch);
+	StencilFetch GetStencilFetch() const { return stencilFetch; }
+
+	// Programs that include frame_constants.glsl read the block from this uniform buffer binding
+	static void BindFrameConstants(CStdGLShaderProgram &program);
+	static constexpr inline GLuint FrameConstantsBinding{0};
+	// The #version 330 stages need it for layout(binding) on their samplers, BindTexture takes the unit from there
+	static constexpr inline const char *SamplerBindingExtension{"GL_ARB_shading_language_420pack"};
+
+private:
+	void UpdateFrameConstants(float dt);
+	Border InitBorder();
+	void SetBounds();
+	bool UsesObstacles() const { return obstacles != nullptr; }
+	void EnsureObstacleStorage(CStdObstacleMask source);
+	void UpdateObstacles(float dt);
+	void BuildObstacleField();
+	const CStdTexture &SolvePressure(const CStdFramebuffer &velocity, const CStdFramebuffer &divergence);
+	void SolvePoissonSystem(CStdSwappableFramebuffer &swappableBuffer, const CStdFramebuffer &initialValue, float alpha, float beta, PoissonSystem system);
+	void SolveJacobi(CStdSwappableFramebuffer &swappableBuffer, const CStdFramebuffer &rightHandSide, float alpha, float beta, PoissonSystem system, const CStdFramebuffer *velocity = nullptr);
+	void JacobiSweep(CStdSwappableFramebuffer &swappableBuffer, const CStdFramebuffer &rightHandSide, float alpha, float beta, PoissonSystem system, float omega = 1.0f);
+	bool UsesFusedDivergence() const;
+	void DivergenceSweep(CStdSwappableFramebuffer &swappableBuffer, const CStdFramebuffer &divergence, const CStdFramebuffer &velocity, float alpha, float beta);
+	bool UsesJacobiBlocking() const;
+	void JacobiBlock(CStdSwappableFramebuffer &swappableBuffer, const CStdFramebuffer &rightHandSide, float alpha, float beta, std::size_t sweeps);
+	const CStdTexture &ComputeResidual(const CStdFramebuffer &field, const CStdFramebuffer &rightHandSide, float alpha, float beta, bool obstacleFaces = false);
+	void IssueResidualCheck(const CStdTexture &residual, const CStdFramebuffer &rightHandSide, float alpha, PoissonSystem system, std::size_t iteration, bool final);
+	void PollResidualChecks(PoissonSystem system);
+	void ReduceResidualNorms(const CStdTexture &residual, const CStdFramebuffer &rightHandSide, float alpha, const CStdBuffer &results, GLint slot);
+	void SolveRedBlackSOR(const CStdFramebuffer &field, const CStdFramebuffer &rightHandSide, float alpha, float beta, std::size_t iterations);
+	bool UsesPackedPressure() const;
+	void SolvePacked(CStdSwappableFramebuffer &swappableBuffer, const CStdFramebuffer &rightHandSide, float alpha, float beta, PoissonSystem system);
+	void EnsurePackedStorage(const CStdFramebuffer &initialValue);
+	bool UsesRefinement() const;
+	void SolveRefined(CStdSwappableFramebuffer &swappableBuffer, const CStdFramebuffer &rightHandSide, float alpha, float beta, PoissonSystem system);
+	void EnsureRefinementStorage(const CStdFramebuffer &initialValue);
+	void SolveMultigrid(CStdSwappableFramebuffer &solution, const CStdFramebuffer &rightHandSide, float alpha, float beta, PoissonSystem system);
+	void EnsureMultigridLevels(MultigridHierarchy &hierarchy, const CStdTexture &field);
+	void RunMultigridCycle(MultigridHierarchy &hierarchy, std::size_t index, MultigridCycle cycle);
+	void Smooth(MultigridLevel &level, std::size_t steps);
+	void SolveConjugateGradient(const CStdFramebuffer &field, const CStdFramebuffer &rightHandSide, float alpha, float beta, PoissonSystem system);
+	void EnsureConjugateGradientStorage();
+	void DispatchCompute();
+	void DispatchSimulation();
+	GLuint GetNumComputeGroupsX() const { return (width + ComputeGroupSize - 1) / ComputeGroupSize; }
+	GLuint GetNumComputeGroupsY() const { return (height + ComputeGroupSize - 1) / ComputeGroupSize; }
+	GLsizeiptr GetNumComputeGroups() const { return static_cast<GLsizeiptr>(GetNumComputeGroupsX()) * GetNumComputeGroupsY(); }
+	void Reduce(const CStdTexture &lhs, const CStdTexture &rhs, GLint slot, bool sum = false);
+	void Precondition(float beta);
+	// The transform of a line keeps 2^k >= 2N - 1 complex values in shared memory, see spectral.comp.
+	// Grids whose lines do not fit GL_MAX_COMPUTE_SHARED_MEMORY_SIZE use the iterative projection, only the initial size is rejected.
+	static std::size_t GetSpectralSharedMemorySize(std::int32_t length);
+	bool UsesSpectralProjection() const;
+	void SolveSpectral(const CStdFramebuffer &field, const CStdFramebuffer &rightHandSide, float alpha, float beta);
+	void EnsureSpectralStorage();
+	void TransformLines(CStdGLShaderProgram &program, const CStdTexture &source, const CStdTexture &destination, bool columns, bool inverse, bool solve);
+	void ResizeFramebuffer(CStdFramebuffer &frameBuffer, std::int32_t newWidth, std::int32_t newHeight);
+	void ResizeFramebuffer(CStdSwappableFramebuffer &swappableBuffer, std::int32_t newWidth, std::int32_t newHeight);
+
+private:
+	static constexpr inline std::size_t NumResidualSlots{32};
+	static constexpr inline std::int32_t MinimumMultigridLevelSize{8};
+	static constexpr inline std::size_t CoarsestSmoothingSteps{32};
+	static constexpr inline float SmoothingWeight{0.8f};
+	static constexpr inline GLuint ComputeGroupSize{16};
+
+	CStdGLShaderProgram advectShaderProgram;
+	CStdGLShaderProgram addImpulseShaderProgram;
+	CStdGLShaderProgram addRadialImpulseShaderProgram;
+	CStdGLShaderProgram vorticityShaderProgram;
+	CStdGLShaderProgram addVorticityShaderProgram;
+	CStdGLShaderProgram divergenceShaderProgram;
+	CStdGLShaderProgram gradientShaderProgram;
+	CStdGLShaderProgram subtractShaderProgram;
+	CStdGLShaderProgram boundaryShaderProgram;
+	CStdGLShaderProgram copyShaderProgram;
+	CStdGLShaderProgram smoothShaderProgram;
+	CStdGLShaderProgram residualShaderProgram;
+	CStdGLShaderProgram prolongateShaderProgram;
+	CStdGLShaderProgram sorShaderProgram;
+	CStdGLShaderProgram packShaderProgram;
+	CStdGLShaderProgram unpackShaderProgram;
+	CStdGLShaderProgram jacobiPackedShaderProgram;
+	CStdGLShaderProgram vorticityConfinementShaderProgram;
+	CStdGLShaderProgram gradientSubtractShaderProgram;
+	CStdGLShaderProgram divergenceJacobiShaderProgram;
+	CStdGLShaderProgram obstaclesShaderProgram;
+	CStdGLShaderProgram pcgInitShaderProgram;
+	CStdGLShaderProgram pcgApplyShaderProgram;
+	CStdGLShaderProgram pcgPreconditionShaderProgram;
+	CStdGLShaderProgram pcgReduceShaderProgram;
+	CStdGLShaderProgram pcgFinishReductionShaderProgram;
+	CStdGLShaderProgram pcgCenterShaderProgram;
+	CStdGLShaderProgram pcgStepShaderProgram;
+	CStdGLShaderProgram pcgDirectionShaderProgram;
+	CStdGLShaderProgram pcgStoreShaderProgram;
+	CStdGLShaderProgram residualNormReduceShaderProgram;
+	CStdGLShaderProgram residualNormFinishShaderProgram;
+	CStdGLShaderProgram spectralStoreShaderProgram;
+	CStdGLShaderProgram refinementInitShaderProgram;
+	CStdGLShaderProgram refinementResidualShaderProgram;
+	CStdGLShaderProgram refinementScaleShaderProgram;
+	CStdGLShaderProgram refinementCorrectShaderProgram;
+	CStdGLShaderProgram simulationAdvectShaderProgram;
+	CStdGLShaderProgram simulationImpulseShaderProgram;
+	CStdGLShaderProgram simulationVorticityShaderProgram;
+	CStdGLShaderProgram simulationAddVorticityShaderProgram;
+	CStdGLShaderProgram simulationDivergenceShaderProgram;
+	CStdGLShaderProgram simulationJacobiBlockedShaderProgram;
+	CStdGLShaderProgram simulationGradientShaderProgram;
+	CStdGLShaderProgram simulationSubtractShaderProgram;
+	CStdGLShaderProgram simulationBoundaryShaderProgram;
+	CStdGLShaderProgram simulationVorticityConfinementShaderProgram;
+	CStdGLShaderProgram simulationGradientSubtractShaderProgram;
+	CStdGLShaderProgram simulationDivergenceJacobiShaderProgram;
+	CStdGLShaderProgram simulationObstaclesShaderProgram;
+	CStdGLShaderProgram obstacleSeedShaderProgram;
+	CStdGLShaderProgram obstacleJumpShaderProgram;
+	CStdGLShaderProgram obstacleResolveShaderProgram;
+	SweepUniforms sorUniforms;
+	SweepUniforms jacobiPackedUniforms;
+	// The axes match the #if defined blocks of the shaders, see JacobiSweep
+	SweepVariants jacobiVariants{{"OBSTACLES", "SCALAR", "GRID_WIDTH", "GRID_HEIGHT"}};
+	SweepVariants chebyshevVariants{{"OBSTACLES"}};
+	SweepVariants simulationJacobiVariants{{"OBSTACLES", "GRID_WIDTH", "GRID_HEIGHT"}};
+	std::vector<CStdGLShaderProgram *> loadingPrograms;
+	std::string spectralSource;
+	StencilFetch stencilFetch{StencilFetch::Filtered};
+
+	CStdRectangle quad;
+	CStdSwappableFramebuffer velocityBuffer;
+	CStdSwappableFramebuffer pressureBuffer;
+	CStdFramebuffer residualBuffer;
+	// Vorticity, divergence, gradient and solver scratch, leased per Step
+	CStdRenderTargetPool targetPool;
+	CStdFrameGraph frameGraph{targetPool};
+	Border border;
+	CStdBuffer frameConstants;
+	// Indexed by PoissonSystem, diffusion and pressure usually differ in format
+	std::array<MultigridHierarchy, 2> multigrid;
+	std::unique_ptr<ConjugateGradientStorage> conjugateGradient;
+	std::unique_ptr<SpectralStorage> spectral;
+	GLint maxComputeSharedMemorySize{0};
+	std::unique_ptr<RefinementStorage> refinement;
+	std::unique_ptr<PackedStorage> packed;
+	std::unique_ptr<ObstacleStorage> obstacles;
+
+	// Persistently mapped, the residual checks are read on the host once their fence has signaled
+	CStdBuffer residualPartials;
+	CStdBuffer residualResults;
+	const glm::vec4 *residualResultsData;
+	std::array<bool, NumResidualSlots> residualSlotBusy{};
+	std::size_t nextResidualSlot{0};
+	std::array<ConvergenceState, 2> convergence;
+	std::size_t passCount{0};
+};
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// Row-major CPU counterpart of CStdFramebuffer, row 0 is the bottom row like in a GL texture
+template<typename T>
+class CStdGrid
+{
+public:
+	CStdGrid() : width{0}, height{0} {}
+	CStdGrid(std::int32_t width, std::int32_t height) : width{width}, height{height}, data(static_cast<std::size_t>(width) * height, T{}) {}
+
+public:
+	T &operator()(std::int32_t x, std::int32_t y) { return data[Index(x, y)]; }
+	const T &operator()(std::int32_t x, std::int32_t y) const { return data[Index(x, y)]; }
+
+	// Wrapping fetch for stencil neighbours, like the GL_REPEAT samplers and the Wrap of the compute kernels
+	const T &Fetch(std::int32_t x, std::int32_t y) const
+	{
+		return data[Index(Wrap(x, width), Wrap(y, height))];
+	}
+
+	// Bilinear lookup at a texture coordinate, like texture2D with GL_LINEAR and GL_REPEAT
+	T Sample(const glm::vec2 &coord) const
+	{
+		const float x{coord.x * width - 0.5f};
+		const float y{coord.y * height - 0.5f};
+		const float x0{std::floor(x)};
+		const float y0{std::floor(y)};
+		const float s{x - x0};
+		const float t{y - y0};
+		const auto i = static_cast<std::int32_t>(x0);
+		const auto j = static_cast<std::int32_t>(y0);
+
+		return (1.0f - t) * ((1.0f - s) * Fetch(i, j) + s * Fetch(i + 1, j))
+			+ t * ((1.0f - s) * Fetch(i, j + 1) + s * Fetch(i + 1, j + 1));
+	}
+
+	void Fill(const T &value) { std::fill(data.begin(), data.end(), value); }
+
+	std::int32_t GetWidth() const { return width; }
+	std::int32_t GetHeight() const { return height; }
+	std::vector<T> &GetData() { return data; }
+	const std::vector<T> &GetData() const { return data; }
+
+private:
+	std::size_t Index(std::int32_t x, std::int32_t y) const { return static_cast<std::size_t>(y) * width + x; }
+
+	static std::int32_t Wrap(std::int32_t i, std::int32_t size)
+	{
+		i %= size;
+		return i < 0 ? i + size : i;
+	}
+
+private:
+	std::int32_t width;
+	std::int32_t height;
+	std::vector<T> data;
+};
+
+// CPU counterpart of CStdSwappableFramebuffer
+template<typename T>
+class CStdSwappableGrid
+{
+public:
+	CStdSwappableGrid() : front{0}, back{1} {}
+	CStdSwappableGrid(std::int32_t width, std::int32_t height) : buffers{CStdGrid<T>{width, height}, CStdGrid<T>{width, height}}, front{0}, back{1} {}
+
+public:
+	void SwapBuffers() { std::swap(front, back); }
+
+	CStdGrid<T> &GetFront() { return buffers[front]; }
+	CStdGrid<T> &GetBack() { return buffers[back]; }
+	const CStdGrid<T> &GetFront() const { return buffers[front]; }
+	const CStdGrid<T> &GetBack() const { return buffers[back]; }
+
+private:
+	CStdGrid<T> buffers[2];
+	std::size_t front;
+	std::size_t back;
+};
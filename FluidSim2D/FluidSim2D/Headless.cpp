@@ -0,0 +1,227 @@
+#include "Headless.h"
+
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include "CPUFluidSolver.h"
+#include "SpectralSolver.h"
+
+namespace
+{
+	struct HeadlessOptions
+	{
+		std::int32_t size{802};
+		std::size_t steps{600};
+		std::size_t threads{std::thread::hardware_concurrency()};
+		std::string dumpFile;
+		bool report{false};
+		bool checkSpectral{false};
+	};
+
+	HeadlessOptions ParseOptions(const int argc, char *argv[])
+	{
+		HeadlessOptions options;
+
+		for (int i{1}; i < argc; ++i)
+		{
+			const std::string_view arg{argv[i]};
+			const bool hasValue{i + 1 < argc};
+
+			if (arg == "--size" && hasValue)
+			{
+				options.size = std::stoi(argv[++i]);
+			}
+			else if (arg == "--steps" && hasValue)
+			{
+				options.steps = std::stoul(argv[++i]);
+			}
+			else if (arg == "--threads" && hasValue)
+			{
+				options.threads = std::stoul(argv[++i]);
+			}
+			else if (arg == "--dump" && hasValue)
+			{
+				options.dumpFile = argv[++i];
+			}
+			else if (arg == "--report")
+			{
+				options.report = true;
+			}
+			else if (arg == "--check-spectral")
+			{
+				options.checkSpectral = true;
+			}
+		}
+
+		return options;
+	}
+
+	// Deterministic stirring impulse moving on a circle around the domain center
+	void ScriptImpulse(ImpulseState &impulseState, const std::size_t step, const std::int32_t size)
+	{
+		static constexpr float StepsPerRevolution{240.0f};
+
+		const float angle{6.2831853f * step / StepsPerRevolution};
+		const float radius{0.25f * size};
+		const float x{0.5f * size + radius * std::cos(angle)};
+		const float y{0.5f * size + radius * std::sin(angle)};
+
+		impulseState.Update(x, y, true, false);
+	}
+
+	// Solves the pressure system 4 * x - (xL + xR + xB + xT) = b for a random b with CStdSpectralSolver and with Jacobi sweeps
+	// run to convergence in double precision. A boundary that differs from the wrapping stencils shows up in the border cells first.
+	// The grid is odd sized, on even sizes Jacobi does not damp the checkerboard mode of the periodic system at all.
+	int CheckSpectral(const std::size_t threads)
+	{
+		static constexpr std::int32_t Width{31};
+		static constexpr std::int32_t Height{29};
+		static constexpr std::size_t MaxSweeps{20000};
+		static constexpr double Tolerance{1e-4};
+
+		std::mt19937 random{1};
+		std::uniform_real_distribution<float> distribution{-1.0f, 1.0f};
+		CStdGrid<float> rightHandSide{Width, Height};
+		for (float &value : rightHandSide.GetData())
+		{
+			value = distribution(random);
+		}
+
+		// The constant mode is the null space, b has to be orthogonal to it
+		double mean{0.0};
+		for (const float value : rightHandSide.GetData())
+		{
+			mean += value;
+		}
+		mean /= rightHandSide.GetData().size();
+		for (float &value : rightHandSide.GetData())
+		{
+			value -= static_cast<float>(mean);
+		}
+
+		CStdThreadPool threadPool{threads};
+		CStdSpectralSolver spectralSolver{threadPool};
+		CStdGrid<float> spectral{Width, Height};
+		spectralSolver.Solve(spectral, rightHandSide, 1.0f, 4.0f);
+
+		CStdSwappableGrid<double> jacobi{Width, Height};
+		std::size_t sweeps{0};
+		for (double change{1.0}; sweeps < MaxSweeps && change > 1e-9; ++sweeps)
+		{
+			const CStdGrid<double> &x{jacobi.GetFront()};
+			CStdGrid<double> &result{jacobi.GetBack()};
+			change = 0.0;
+			for (std::int32_t y{0}; y < Height; ++y)
+			{
+				for (std::int32_t x0{0}; x0 < Width; ++x0)
+				{
+					result(x0, y) = (x.Fetch(x0 - 1, y) + x.Fetch(x0 + 1, y) + x.Fetch(x0, y - 1) + x.Fetch(x0, y + 1) + rightHandSide(x0, y)) / 4.0;
+					change = std::max(change, std::abs(result(x0, y) - x(x0, y)));
+				}
+			}
+			jacobi.SwapBuffers();
+		}
+
+		// Both solutions are only defined up to a constant, the spectral one has zero mean
+		double jacobiMean{0.0};
+		double magnitude{0.0};
+		for (const double value : jacobi.GetFront().GetData())
+		{
+			jacobiMean += value;
+		}
+		jacobiMean /= jacobi.GetFront().GetData().size();
+
+		double borderDifference{0.0};
+		double interiorDifference{0.0};
+		for (std::int32_t y{0}; y < Height; ++y)
+		{
+			for (std::int32_t x{0}; x < Width; ++x)
+			{
+				const double expected{jacobi.GetFront()(x, y) - jacobiMean};
+				const double difference{std::abs(spectral(x, y) - expected)};
+				magnitude = std::max(magnitude, std::abs(expected));
+
+				double &maxDifference{x == 0 || y == 0 || x == Width - 1 || y == Height - 1 ? borderDifference : interiorDifference};
+				maxDifference = std::max(maxDifference, difference);
+			}
+		}
+
+		const double tolerance{Tolerance * magnitude};
+		const bool passed{borderDifference <= tolerance && interiorDifference <= tolerance};
+		std::cout << "Spectral vs. Jacobi (" << sweeps << " sweeps) on " << Width << "x" << Height << ": max difference border " << borderDifference
+			<< ", interior " << interiorDifference << ", tolerance " << tolerance << (passed ? ", ok\n" : ", FAILED\n");
+
+		return passed ? 0 : 1;
+	}
+}
+
+int RunHeadless(const int argc, char *argv[])
+{
+	const HeadlessOptions options{ParseOptions(argc, argv)};
+	if (options.checkSpectral)
+	{
+		return CheckSpectral(options.threads);
+	}
+
+	Variables vars;
+	ParseVariables(argc, argv, vars, {{"--headless", false}, {"--shader-dir", true}, {"--size", true}, {"--steps", true}, {"--threads", true}, {"--dump", true}, {"--report", false}});
+
+	CStdCPUFluidSolver solver{vars, options.size, options.size, options.threads};
+	ImpulseState impulseState;
+
+	std::cout << "Headless CPU solver: " << options.size << "x" << options.size << ", " << options.steps << " steps, " << solver.GetNumThreads() << " threads\n";
+
+	static constexpr float TimeStep{0.016667f};
+	const auto start = std::chrono::steady_clock::now();
+
+	std::size_t diffusionIterations{0};
+	std::size_t pressureIterations{0};
+
+	for (std::size_t step{0}; step < options.steps; ++step)
+	{
+		ScriptImpulse(impulseState, step, options.size);
+		solver.Step(TimeStep, impulseState);
+
+		const PoissonStatistics &diffusion{solver.GetPoissonStatistics(PoissonSystem::Diffusion)};
+		const PoissonStatistics &pressure{solver.GetPoissonStatistics(PoissonSystem::Pressure)};
+		diffusionIterations += diffusion.iterations;
+		pressureIterations += pressure.iterations;
+
+		if (options.report)
+		{
+			std::cout << "Step " << step << ": diffusion " << diffusion.iterations << " iterations, residual " << diffusion.residual
+				<< ", pressure " << pressure.iterations << " iterations, residual " << pressure.residual << " (max " << pressure.maxResidual << ")\n";
+		}
+	}
+
+	const std::chrono::duration<double> elapsed{std::chrono::steady_clock::now() - start};
+	const double cells{static_cast<double>(options.size) * options.size};
+
+	const auto velocity = solver.GetVelocity();
+	double energy{0.0};
+	for (const auto &v : velocity)
+	{
+		energy += 0.5 * glm::dot(v, v);
+	}
+
+	std::cout << "Elapsed: " << elapsed.count() << " s, "
+		<< options.steps / elapsed.count() << " steps/s, "
+		<< cells * options.steps / elapsed.count() * 1e-6 << " Mcells/s\n"
+		<< "Kinetic energy: " << energy / cells << "\n"
+		<< "Average iterations: diffusion " << static_cast<double>(diffusionIterations) / options.steps
+		<< ", pressure " << static_cast<double>(pressureIterations) / options.steps << "\n";
+
+	if (!options.dumpFile.empty())
+	{
+		std::ofstream file{options.dumpFile, std::ios::binary};
+		file.write(reinterpret_cast<const char *>(velocity.data()), static_cast<std::streamsize>(velocity.size() * sizeof(glm::vec2)));
+	}
+
+	return 0;
+}
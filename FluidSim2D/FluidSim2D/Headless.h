@@ -0,0 +1,6 @@
+#pragma once
+
+// Runs the CPU solver without a window or GL context.
+// Options: --size <cells> --steps <count> --threads <count> --dump <file> --report
+// --check-spectral compares the spectral pressure solve against converged Jacobi sweeps instead and returns 1 if they disagree.
+int RunHeadless(int argc, char *argv[]);
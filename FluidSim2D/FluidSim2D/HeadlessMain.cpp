@@ -0,0 +1,8 @@
+// Entry point of the headless build, see CMakeLists.txt. The Visual Studio project starts in FluidSim2D.cpp instead.
+
+#include "Headless.h"
+
+int main(int argc, char *argv[])
+{
+	return RunHeadless(argc, argv);
+}
@@ -0,0 +1,173 @@
+#pragma once
+
+#include <memory>
+
+#include "FluidSolver.h"
+#include "Grid.h"
+#include "ThreadPool.h"
+
+// Cell-centered geometric multigrid for the systems SolvePoissonSystem handles:
+//   beta * x - (xL + xR + xB + xT) = alpha * b
+// Coarse levels halve the resolution. The system is scaled by the squared grid spacing,
+// so the right hand side and the diagonal surplus (beta - 4) grow by a factor of 4 per level.
+template<typename T>
+class CStdMultigridSolver
+{
+	struct Level
+	{
+		CStdSwappableGrid<T> *solution;
+		const CStdGrid<T> *rightHandSide;
+		CStdGrid<T> residual;
+		float alpha;
+		float beta;
+	};
+
+	struct CoarseStorage
+	{
+		CStdSwappableGrid<T> solution;
+		CStdGrid<T> rightHandSide;
+	};
+
+public:
+	explicit CStdMultigridSolver(CStdThreadPool &threadPool) : threadPool{threadPool} {}
+
+public:
+	void Solve(CStdSwappableGrid<T> &solution, const CStdGrid<T> &rightHandSide, const float alpha, const float beta, const Variables &vars)
+	{
+		EnsureLevels(solution.GetFront().GetWidth(), solution.GetFront().GetHeight());
+
+		levels[0].solution = &solution;
+		levels[0].rightHandSide = &rightHandSide;
+		levels[0].alpha = alpha;
+		levels[0].beta = beta;
+
+		for (std::size_t i{1}; i < levels.size(); ++i)
+		{
+			levels[i].alpha = 4.0f;
+			levels[i].beta = 4.0f + 4.0f * (levels[i - 1].beta - 4.0f);
+		}
+
+		for (std::size_t i{0}; i < vars.multigridCycles; ++i)
+		{
+			Cycle(0, vars.multigridCycle, vars.multigridSmoothingSteps);
+		}
+	}
+
+private:
+	static constexpr inline std::int32_t MinimumLevelSize{8};
+	static constexpr inline std::size_t CoarsestSmoothingSteps{32};
+	static constexpr inline float SmoothingWeight{0.8f};
+
+	void EnsureLevels(const std::int32_t width, const std::int32_t height)
+	{
+		if (!levels.empty() && levels[0].residual.GetWidth() == width && levels[0].residual.GetHeight() == height)
+		{
+			return;
+		}
+
+		levels.clear();
+		storage.clear();
+
+		std::int32_t levelWidth{width};
+		std::int32_t levelHeight{height};
+		levels.push_back({nullptr, nullptr, CStdGrid<T>{levelWidth, levelHeight}, 0.0f, 0.0f});
+
+		// Like CStdGLFluidSolver::EnsureMultigridLevels, an odd size ends the hierarchy, 2x2 blocks only tile even sizes with the periodic wrap
+		while (levelWidth % 2 == 0 && levelHeight % 2 == 0 && std::min(levelWidth, levelHeight) / 2 >= MinimumLevelSize)
+		{
+			levelWidth /= 2;
+			levelHeight /= 2;
+
+			auto &coarse = *storage.emplace_back(std::make_unique<CoarseStorage>(CoarseStorage{{levelWidth, levelHeight}, {levelWidth, levelHeight}}));
+			levels.push_back({&coarse.solution, &coarse.rightHandSide, CStdGrid<T>{levelWidth, levelHeight}, 0.0f, 0.0f});
+		}
+	}
+
+	void Cycle(const std::size_t index, const MultigridCycle cycle, const std::size_t smoothingSteps)
+	{
+		Level &level{levels[index]};
+
+		if (index + 1 == levels.size())
+		{
+			Smooth(level, CoarsestSmoothingSteps);
+			return;
+		}
+
+		Smooth(level, smoothingSteps);
+
+		Level &coarse{levels[index + 1]};
+		ComputeResidual(level);
+		Restrict(level.residual, storage[index]->rightHandSide);
+		coarse.solution->GetFront().Fill(T{});
+
+		if (cycle == MultigridCycle::F)
+		{
+			Cycle(index + 1, MultigridCycle::F, smoothingSteps);
+		}
+		Cycle(index + 1, MultigridCycle::V, smoothingSteps);
+
+		Prolongate(coarse.solution->GetFront(), level.solution->GetFront());
+		Smooth(level, smoothingSteps);
+	}
+
+	// Damped Jacobi, smooth.frag
+	void Smooth(Level &level, const std::size_t steps)
+	{
+		const float inverseBeta{1.0f / level.beta};
+		const CStdGrid<T> &rightHandSide{*level.rightHandSide};
+
+		for (std::size_t i{0}; i < steps; ++i)
+		{
+			const auto &field = level.solution->GetFront();
+			auto &result = level.solution->GetBack();
+
+			threadPool.ForEachCell(field.GetWidth(), field.GetHeight(), [&](const std::int32_t x, const std::int32_t y)
+			{
+				const T jacobi{(field.Fetch(x - 1, y) + field.Fetch(x + 1, y) + field.Fetch(x, y - 1) + field.Fetch(x, y + 1) + level.alpha * rightHandSide(x, y)) * inverseBeta};
+				result(x, y) = field(x, y) + SmoothingWeight * (jacobi - field(x, y));
+			});
+
+			level.solution->SwapBuffers();
+		}
+	}
+
+	// residual.frag
+	void ComputeResidual(Level &level)
+	{
+		const auto &field = level.solution->GetFront();
+		const CStdGrid<T> &rightHandSide{*level.rightHandSide};
+
+		threadPool.ForEachCell(field.GetWidth(), field.GetHeight(), [&](const std::int32_t x, const std::int32_t y)
+		{
+			const T neighbours{field.Fetch(x - 1, y) + field.Fetch(x + 1, y) + field.Fetch(x, y - 1) + field.Fetch(x, y + 1)};
+			level.residual(x, y) = level.alpha * rightHandSide(x, y) - (level.beta * field(x, y) - neighbours);
+		});
+	}
+
+	// Bilinear lookup at the coarse cell center averages the 2x2 fine cells beneath it, like copy.frag into a half size target
+	void Restrict(const CStdGrid<T> &fine, CStdGrid<T> &coarse)
+	{
+		const glm::vec2 scale{1.0f / coarse.GetWidth(), 1.0f / coarse.GetHeight()};
+
+		threadPool.ForEachCell(coarse.GetWidth(), coarse.GetHeight(), [&](const std::int32_t x, const std::int32_t y)
+		{
+			coarse(x, y) = fine.Sample(glm::vec2{x + 0.5f, y + 0.5f} * scale);
+		});
+	}
+
+	// prolongate.frag
+	void Prolongate(const CStdGrid<T> &coarse, CStdGrid<T> &fine)
+	{
+		const glm::vec2 scale{1.0f / fine.GetWidth(), 1.0f / fine.GetHeight()};
+
+		threadPool.ForEachCell(fine.GetWidth(), fine.GetHeight(), [&](const std::int32_t x, const std::int32_t y)
+		{
+			fine(x, y) += coarse.Sample(glm::vec2{x + 0.5f, y + 0.5f} * scale);
+		});
+	}
+
+private:
+	CStdThreadPool &threadPool;
+	std::vector<Level> levels;
+	std::vector<std::unique_ptr<CoarseStorage>> storage;
+};
@@ -0,0 +1,102 @@
+#include "ObstacleMask.h"
+
+#include <fstream>
+#include <string>
+
+namespace
+{
+	// Skips whitespace and # comments between the header fields
+	std::int32_t ReadHeaderValue(std::istream &stream)
+	{
+		stream >> std::ws;
+		while (stream.peek() == '#')
+		{
+			std::string comment;
+			std::getline(stream, comment);
+			stream >> std::ws;
+		}
+
+		std::int32_t value{0};
+		if (!(stream >> value) || value <= 0)
+		{
+			throw CStdObstacleMask::Exception{"Invalid PGM header"};
+		}
+
+		return value;
+	}
+}
+
+CStdObstacleMask CStdObstacleMask::Load(const std::string_view path)
+{
+	std::ifstream file{std::string{path}, std::ios::binary};
+	if (!file)
+	{
+		throw Exception{"Cannot open obstacle mask: " + std::string{path}};
+	}
+
+	std::string magic;
+	file >> magic;
+	if (magic != "P5" && magic != "P2")
+	{
+		throw Exception{"Obstacle mask is not a PGM image: " + std::string{path}};
+	}
+
+	const std::int32_t width{ReadHeaderValue(file)};
+	const std::int32_t height{ReadHeaderValue(file)};
+	const std::int32_t maxValue{ReadHeaderValue(file)};
+	if (maxValue > 65535)
+	{
+		throw Exception{"Invalid PGM header"};
+	}
+
+	CStdObstacleMask mask{width, height};
+	const bool binary{magic == "P5"};
+	const bool wide{maxValue > 255};
+
+	// Exactly one whitespace character separates the header from binary data
+	if (binary)
+	{
+		file.get();
+	}
+
+	for (std::int32_t row{0}; row < height; ++row)
+	{
+		for (std::int32_t x{0}; x < width; ++x)
+		{
+			std::int32_t value{0};
+			if (binary)
+			{
+				const int high{file.get()};
+				value = wide ? (high << 8) | file.get() : high;
+			}
+			else
+			{
+				file >> value;
+			}
+
+			if (!file)
+			{
+				throw Exception{"Truncated obstacle mask: " + std::string{path}};
+			}
+
+			// PGM rows run from the top
+			mask.SetSolid(x, height - 1 - row, 2 * value < maxValue);
+		}
+	}
+
+	return mask;
+}
+
+CStdObstacleMask CStdObstacleMask::Resample(const std::int32_t newWidth, const std::int32_t newHeight) const
+{
+	CStdObstacleMask result{newWidth, newHeight};
+	for (std::int32_t y{0}; y < newHeight; ++y)
+	{
+		for (std::int32_t x{0}; x < newWidth; ++x)
+		{
+			result.SetSolid(x, y, IsSolid(static_cast<std::int32_t>(static_cast<std::int64_t>(x) * width / newWidth), static_cast<std::int32_t>(static_cast<std::int64_t>(y) * height / newHeight)));
+		}
+	}
+
+	return result;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+// Solid cells of the domain, row-major with row 0 at the bottom like the velocity field
+class CStdObstacleMask
+{
+public:
+	class Exception : public std::runtime_error
+	{
+	public:
+		using runtime_error::runtime_error;
+	};
+
+public:
+	CStdObstacleMask() : width{0}, height{0} {}
+	CStdObstacleMask(std::int32_t width, std::int32_t height) : width{width}, height{height}, cells(static_cast<std::size_t>(width) * height, 0) {}
+
+public:
+	// Binary (P5) or plain (P2) PGM, pixels darker than half the maximum value are solid
+	static CStdObstacleMask Load(std::string_view path);
+
+	// Nearest neighbour
+	CStdObstacleMask Resample(std::int32_t newWidth, std::int32_t newHeight) const;
+
+	bool IsSolid(std::int32_t x, std::int32_t y) const { return cells[static_cast<std::size_t>(y) * width + x] != 0; }
+	void SetSolid(std::int32_t x, std::int32_t y, bool solid) { cells[static_cast<std::size_t>(y) * width + x] = solid ? 255 : 0; }
+
+	std::int32_t GetWidth() const { return width; }
+	std::int32_t GetHeight() const { return height; }
+	// One byte per cell, 255 for solid cells
+	const std::vector<std::uint8_t> &GetCells() const { return cells; }
+
+private:
+	std::int32_t width;
+	std::int32_t height;
+	std::vector<std::uint8_t> cells;
+};
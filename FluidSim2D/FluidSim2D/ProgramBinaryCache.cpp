@@ -0,0 +1,135 @@
+#include "ProgramBinaryCache.h"
+
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <system_error>
+#include <vector>
+
+namespace
+{
+	constexpr std::uint32_t Magic{0x42505346}; // "FSPB"
+
+	struct Header
+	{
+		std::uint32_t magic;
+		std::uint32_t format;
+		std::uint64_t key;
+		std::uint64_t length;
+	};
+
+	// 64 bit FNV-1a, stable across runs and compilers unlike std::hash
+	std::uint64_t Hash(const std::string_view data, std::uint64_t hash = 0xcbf29ce484222325)
+	{
+		for (const char c : data)
+		{
+			hash ^= static_cast<unsigned char>(c);
+			hash *= 0x100000001b3;
+		}
+
+		return hash;
+	}
+
+	std::string_view GetString(const GLenum name)
+	{
+		const GLubyte *const string{glGetString(name)};
+		return string ? reinterpret_cast<const char *>(string) : "";
+	}
+}
+
+CStdProgramBinaryCache::CStdProgramBinaryCache(std::filesystem::path directory) : directory{std::move(directory)}, enabled{false}
+{
+	GLint formats{0};
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+
+	std::error_code error;
+	std::filesystem::create_directories(this->directory, error);
+	enabled = formats > 0 && !error;
+
+	driver.append(GetString(GL_VENDOR)).append("\n").append(GetString(GL_RENDERER)).append("\n").append(GetString(GL_VERSION)).append("\n");
+}
+
+std::uint64_t CStdProgramBinaryCache::GetKey(const std::string_view sources) const
+{
+	return Hash(sources, Hash(driver));
+}
+
+bool CStdProgramBinaryCache::Load(const GLuint program, const std::uint64_t key)
+{
+	if (!enabled)
+	{
+		return false;
+	}
+
+	std::ifstream file{GetPath(key), std::ios::binary};
+	Header header;
+	if (!file.read(reinterpret_cast<char *>(&header), sizeof(header)) || header.magic != Magic || header.key != key)
+	{
+		return false;
+	}
+
+	std::vector<char> binary(header.length);
+	if (!file.read(binary.data(), binary.size()))
+	{
+		return false;
+	}
+
+	glProgramBinary(program, header.format, binary.data(), static_cast<GLsizei>(binary.size()));
+
+	// Fails if the driver no longer accepts the format, the program is then linked from source as usual
+	GLint status{GL_FALSE};
+	glGetProgramiv(program, GL_LINK_STATUS, &status);
+	if (!status)
+	{
+		return false;
+	}
+
+	++counters.loaded;
+	return true;
+}
+
+void CStdProgramBinaryCache::Store(const GLuint program, const std::uint64_t key)
+{
+	++counters.compiled;
+	if (!enabled)
+	{
+		return;
+	}
+
+	GLint length{0};
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0)
+	{
+		return;
+	}
+
+	std::vector<char> binary(length);
+	Header header{Magic, GL_NONE, key, 0};
+	GLsizei written{0};
+	glGetProgramBinary(program, length, &written, &header.format, binary.data());
+	header.length = written;
+
+	// Written under a temporary name first, an interrupted write must not leave a truncated entry behind
+	const std::filesystem::path path{GetPath(key)};
+	std::filesystem::path temporary{path};
+	temporary += ".tmp";
+	{
+		std::ofstream file{temporary, std::ios::binary | std::ios::trunc};
+		file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+		file.write(binary.data(), written);
+		if (!file)
+		{
+			return;
+		}
+	}
+
+	std::error_code error;
+	std::filesystem::rename(temporary, path, error);
+}
+
+std::filesystem::path CStdProgramBinaryCache::GetPath(const std::uint64_t key) const
+{
+	std::ostringstream name;
+	name << std::hex << std::setw(16) << std::setfill('0') << key << ".bin";
+	return directory / name.str();
+}
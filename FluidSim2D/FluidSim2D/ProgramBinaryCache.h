@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+#include <glad/glad.h>
+
+// glGetProgramBinary blobs on disk, one file per program. The key hashes the preprocessed sources of the program
+// together with the vendor, renderer and version strings, so edited shaders and driver updates miss by themselves.
+// A blob the driver rejects counts as a miss, the program is compiled again and the file overwritten.
+class CStdProgramBinaryCache
+{
+public:
+	struct Counters
+	{
+		std::size_t loaded{0};
+		std::size_t compiled{0};
+	};
+
+public:
+	// Needs a current context, drivers without binary formats leave the cache disabled
+	explicit CStdProgramBinaryCache(std::filesystem::path directory);
+
+public:
+	std::uint64_t GetKey(std::string_view sources) const;
+	// True if the program is linked from the cached binary
+	bool Load(GLuint program, std::uint64_t key);
+	// Expects a program linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set
+	void Store(GLuint program, std::uint64_t key);
+
+	bool IsEnabled() const { return enabled; }
+	const Counters &GetCounters() const { return counters; }
+
+private:
+	std::filesystem::path GetPath(std::uint64_t key) const;
+
+private:
+	std::filesystem::path directory;
+	std::string driver;
+	bool enabled;
+	Counters counters;
+};
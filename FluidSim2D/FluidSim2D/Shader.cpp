@@ -1,5 +1,104 @@
 #include "Shader.h"
 
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include "EmbeddedShaders.h"
+#include "ProgramBinaryCache.h"
+
+// KHR_parallel_shader_compile, not part of the generated loader
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+namespace
+{
+	std::string shaderDirectory;
+
+	std::string ReadShaderFile(const std::string_view name)
+	{
+		std::ifstream file;
+		file.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+		file.open(shaderDirectory + "/" + std::string{name});
+
+		return {std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+	}
+
+	// Same rules as EmbedShaders.py: every file is inlined once, #line restores the numbering of the including file
+	std::string ResolveIncludes(const std::string_view name, std::vector<std::string>& included)
+	{
+		std::istringstream source{ReadShaderFile(name)};
+		std::string result;
+		std::size_t number{0};
+		for (std::string line; std::getline(source, line);)
+		{
+			++number;
+
+			const std::size_t directive{line.find("#include")};
+			const std::size_t begin{line.find('"')};
+			const std::size_t end{line.rfind('"')};
+			if (directive == std::string::npos || line.find_first_not_of(" \t") != directive || begin == std::string::npos || begin == end)
+			{
+				result.append(line).append("\n");
+				continue;
+			}
+
+			const std::string include{line.substr(begin + 1, end - begin - 1)};
+			if (std::find(included.begin(), included.end(), include) == included.end())
+			{
+				included.push_back(include);
+				result.append("#line 1\n").append(ResolveIncludes(include, included));
+				result.append("#line ").append(std::to_string(number + 1));
+			}
+
+			result.append("\n");
+		}
+
+		return result;
+	}
+
+	// Compares name with group + key like std::string_view::compare, without building the concatenation
+	int CompareGroupedName(const std::string_view name, const std::string_view group, const std::string_view key)
+	{
+		const std::string_view prefix{name.substr(0, group.size())};
+		if (const int result{prefix.compare(group)}; result != 0)
+		{
+			return result;
+		}
+
+		return name.substr(prefix.size()).compare(key);
+	}
+}
+
+std::string LoadShader(std::string_view name)
+{
+	if (!shaderDirectory.empty())
+	{
+		std::vector<std::string> included;
+		return ResolveIncludes(name, included);
+	}
+
+	const auto it = std::lower_bound(std::begin(EmbeddedShaders::Files), std::end(EmbeddedShaders::Files), name, [](const EmbeddedShaders::File& file, const std::string_view name)
+	{
+		return file.name < name;
+	});
+
+	if (it == std::end(EmbeddedShaders::Files) || it->name != name)
+	{
+		throw std::invalid_argument{"Unknown shader: " + std::string{name}};
+	}
+
+	return std::string{it->source};
+}
+
+void SetShaderDirectory(const std::string& directory)
+{
+	shaderDirectory = directory;
+}
+
 void CStdShader::SetMacro(const std::string& key, const std::string& value)
 {
 	macros[key] = value;
@@ -20,6 +119,11 @@ void CStdShader::AddInclude(const std::string& source)
 	includes.emplace_back(source);
 }
 
+void CStdShader::AddExtension(const std::string& name)
+{
+	extensions.emplace_back(name);
+}
+
 void CStdShader::SetType(Type type)
 {
 	this->type = type;
@@ -30,10 +134,128 @@ void CStdShader::Clear()
 	source.clear();
 	macros.clear();
 	includes.clear();
+	extensions.clear();
 	errorMessage.clear();
 }
 
+GLuint CStdGLState::program{Unknown};
+GLuint CStdGLState::framebuffer{Unknown};
+glm::ivec4 CStdGLState::viewport{-1};
+GLuint CStdGLState::vertexArray{Unknown};
+GLuint CStdGLState::activeTexture{Unknown};
+std::array<GLuint, CStdGLState::NumTextureUnits> CStdGLState::textures{[]
+{
+	std::array<GLuint, NumTextureUnits> textures;
+	textures.fill(Unknown);
+	return textures;
+}()};
+CStdGLState::Counters CStdGLState::counters;
+
+bool CStdGLState::Filter(const bool unchanged)
+{
+	++(unchanged ? counters.filtered : counters.issued);
+	return unchanged;
+}
+
+void CStdGLState::UseProgram(const GLuint program)
+{
+	if (!Filter(CStdGLState::program == program))
+	{
+		glUseProgram(program);
+		CStdGLState::program = program;
+	}
+}
+
+void CStdGLState::BindFramebuffer(const GLuint framebuffer)
+{
+	if (!Filter(CStdGLState::framebuffer == framebuffer))
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+		CStdGLState::framebuffer = framebuffer;
+	}
+}
+
+void CStdGLState::Viewport(const GLint x, const GLint y, const GLsizei width, const GLsizei height)
+{
+	const glm::ivec4 newViewport{x, y, width, height};
+	if (!Filter(viewport == newViewport))
+	{
+		glViewport(x, y, width, height);
+		viewport = newViewport;
+	}
+}
+
+void CStdGLState::BindVertexArray(const GLuint vertexArray)
+{
+	if (!Filter(CStdGLState::vertexArray == vertexArray))
+	{
+		glBindVertexArray(vertexArray);
+		CStdGLState::vertexArray = vertexArray;
+	}
+}
+
+// Only GL_TEXTURE_2D is tracked, the other targets of a unit are bound every time
+void CStdGLState::BindTexture(const GLuint unit, const GLenum target, const GLuint texture)
+{
+	const bool tracked{target == GL_TEXTURE_2D && unit < NumTextureUnits};
+	if (Filter(tracked && textures[unit] == texture))
+	{
+		return;
+	}
+
+	if (activeTexture != unit)
+	{
+		glActiveTexture(GL_TEXTURE0 + unit);
+		activeTexture = unit;
+	}
+
+	glBindTexture(target, texture);
+	if (tracked)
+	{
+		textures[unit] = texture;
+	}
+}
+
+// A deleted program stays in use until another one is selected, so its name cannot come back before that
+void CStdGLState::OnDeleteProgram(const GLuint program)
+{
+	if (CStdGLState::program == program)
+	{
+		CStdGLState::program = Unknown;
+	}
+}
+
+void CStdGLState::OnDeleteFramebuffer(const GLuint framebuffer)
+{
+	if (CStdGLState::framebuffer == framebuffer)
+	{
+		CStdGLState::framebuffer = GL_NONE;
+	}
+}
+
+void CStdGLState::OnDeleteVertexArray(const GLuint vertexArray)
+{
+	if (CStdGLState::vertexArray == vertexArray)
+	{
+		CStdGLState::vertexArray = GL_NONE;
+	}
+}
+
+void CStdGLState::OnDeleteTexture(const GLuint texture)
+{
+	std::replace(textures.begin(), textures.end(), texture, GLuint{GL_NONE});
+}
+
+void CStdGLState::Invalidate()
+{
+	program = framebuffer = vertexArray = activeTexture = Unknown;
+	viewport = glm::ivec4{-1};
+	textures.fill(Unknown);
+}
+
 CStdShaderProgram* CStdShaderProgram::currentShaderProgram = nullptr;
+CStdProgramBinaryCache* CStdGLShaderProgram::binaryCache = nullptr;
+bool CStdGLShaderProgram::parallelCompile = false;
 
 bool CStdShaderProgram::AddShader(CStdShader* shader)
 {
@@ -57,13 +279,11 @@ void CStdShaderProgram::Clear()
 	shaders.clear();
 }
 
+// CStdGLState drops the call if the program is already in use, a relinked program gets selected again
 void CStdShaderProgram::Select()
 {
-	if (currentShaderProgram != this)
-	{
-		OnSelect();
-		currentShaderProgram = this;
-	}
+	OnSelect();
+	currentShaderProgram = this;
 }
 
 void CStdShaderProgram::Deselect()
@@ -85,9 +305,20 @@ void CStdGLShader::Compile()
 	if (shader) // recompiling?
 	{
 		glDeleteShader(shader);
+		shader = 0;
 		errorMessage.clear();
 	}
 
+	preparedSource = PrepareSource();
+}
+
+void CStdGLShader::Submit()
+{
+	if (shader)
+	{
+		return;
+	}
+
 	GLenum t;
 	switch (type)
 	{
@@ -126,8 +357,13 @@ void CStdGLShader::Compile()
 		throw Exception{"Could not create shader"};
 	}
 
-	PrepareSource();
+	const char* s = preparedSource.c_str();
+	glShaderSource(shader, 1, &s, nullptr);
+	glCompileShader(shader);
+}
 
+void CStdGLShader::CheckStatus(const GLuint shader)
+{
 	GLint status = 0;
 	glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
 	if (!status)
@@ -157,12 +393,11 @@ void CStdGLShader::Clear()
 	CStdShader::Clear();
 }
 
-void CStdGLShader::PrepareSource()
+std::string CStdGLShader::PrepareSource() const
 {
 	size_t pos = source.find("#version");
 	if (pos == std::string::npos)
 	{
-		glDeleteShader(shader);
 		throw Exception{"Version directive must be first statement and may not be repeated"};
 	}
 
@@ -172,6 +407,14 @@ void CStdGLShader::PrepareSource()
 	std::string copy = source;
 	std::string buffer = "";
 
+	// #extension has to precede everything but other directives, the includes declare uniforms
+	for (const auto &extension : extensions)
+	{
+		buffer.append("#extension ");
+		buffer.append(extension);
+		buffer.append(" : require\n");
+	}
+
 	for (const auto& [key, value] : macros)
 	{
 		buffer.append("#define ");
@@ -184,80 +427,187 @@ void CStdGLShader::PrepareSource()
 	for (const auto &include : includes)
 	{
 		buffer.append(include);
+		if (!include.empty() && include.back() != '\n')
+		{
+			buffer.append("\n");
+		}
 	}
 
-	buffer.append("#line 1\n");
+	// Numbers the line after #version as in the file, EmbedShaders.py keeps the numbering past includes the same way
+	buffer.append("#line ").append(std::to_string(std::count(source.begin(), source.begin() + pos + 1, '\n') + 1)).append("\n");
 
 	copy.insert(pos + 1, buffer);
-
-	const char* s = copy.c_str();
-	glShaderSource(shader, 1, &s, nullptr);
-	glCompileShader(shader);
+	return copy;
 }
 
 void CStdGLShaderProgram::Link()
 {
-	EnsureProgram();
+	BeginLink();
+	FinishLink();
+}
 
-	glLinkProgram(shaderProgram);
+void CStdGLShaderProgram::BeginLink()
+{
+	EnsureProgram();
+	assert(linkState == LinkState::Idle);
 
-	GLint status = 0;
-	glGetProgramiv(shaderProgram, GL_LINK_STATUS, &status);
-	if (!status)
+	if (binaryCache)
 	{
-		GLint size = 0;
-		glGetProgramiv(shaderProgram, GL_INFO_LOG_LENGTH, &size);
-		assert(size);
-		if (size)
+		std::string sources;
+		for (const auto& shader : shaders)
 		{
-			std::string errorMessage;
-			errorMessage.resize(size);
-			glGetProgramInfoLog(shaderProgram, size, NULL, errorMessage.data());
-			throw Exception{errorMessage.c_str()};
+			sources.append(std::to_string(static_cast<int>(shader->GetType()))).append("\n");
+			sources.append(static_cast<CStdGLShader*>(shader)->GetPreparedSource());
 		}
 
-		throw Exception{"Unknown error"};
+		binaryKey = binaryCache->GetKey(sources);
+		if (binaryCache->Load(shaderProgram, binaryKey))
+		{
+			shaders.clear();
+			linkState = LinkState::Cached;
+			return;
+		}
+
+		glProgramParameteri(shaderProgram, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
 	}
 
-	glValidateProgram(shaderProgram);
-	glGetProgramiv(shaderProgram, GL_VALIDATE_STATUS, &status);
-	if (!status)
+	// The shaders may be gone by FinishLink, attached ones are only flagged for deletion until they are detached
+	for (const auto& shader : shaders)
 	{
-		GLint size = 0;
-		glGetProgramiv(shaderProgram, GL_INFO_LOG_LENGTH, &size);
-		if (size)
+		auto* glShader = static_cast<CStdGLShader*>(shader);
+		glShader->Submit();
+		glAttachShader(shaderProgram, glShader->GetHandle());
+		attachedShaders.push_back(glShader->GetHandle());
+	}
+
+	shaders.clear();
+
+	glLinkProgram(shaderProgram);
+	linkState = LinkState::Linking;
+}
+
+bool CStdGLShaderProgram::IsLinkComplete() const
+{
+	if (linkState != LinkState::Linking || !parallelCompile)
+	{
+		return true;
+	}
+
+	GLint complete = GL_TRUE;
+	glGetProgramiv(shaderProgram, GL_COMPLETION_STATUS_KHR, &complete);
+	return complete;
+}
+
+void CStdGLShaderProgram::FinishLink()
+{
+	if (linkState == LinkState::Linking)
+	{
+		GLint status = 0;
+		glGetProgramiv(shaderProgram, GL_LINK_STATUS, &status);
+		if (!status)
 		{
-			errorMessage.resize(size);
-			glGetProgramInfoLog(shaderProgram, size, NULL, errorMessage.data());
-			throw Exception{errorMessage.c_str()};
+			// A shader that did not compile explains more than the linker does
+			for (const GLuint shader : attachedShaders)
+			{
+				CStdGLShader::CheckStatus(shader);
+			}
+
+			GLint size = 0;
+			glGetProgramiv(shaderProgram, GL_INFO_LOG_LENGTH, &size);
+			assert(size);
+			if (size)
+			{
+				std::string errorMessage;
+				errorMessage.resize(size);
+				glGetProgramInfoLog(shaderProgram, size, NULL, errorMessage.data());
+				throw Exception{errorMessage.c_str()};
+			}
+
+			throw Exception{"Unknown error"};
 		}
 
-		throw Exception{"Unknown error"};
+		glValidateProgram(shaderProgram);
+		glGetProgramiv(shaderProgram, GL_VALIDATE_STATUS, &status);
+		if (!status)
+		{
+			GLint size = 0;
+			glGetProgramiv(shaderProgram, GL_INFO_LOG_LENGTH, &size);
+			if (size)
+			{
+				errorMessage.resize(size);
+				glGetProgramInfoLog(shaderProgram, size, NULL, errorMessage.data());
+				throw Exception{errorMessage.c_str()};
+			}
+
+			throw Exception{"Unknown error"};
+		}
+
+		for (const GLuint shader : attachedShaders)
+		{
+			glDetachShader(shaderProgram, shader);
+		}
+
+		attachedShaders.clear();
+
+		if (binaryCache)
+		{
+			binaryCache->Store(shaderProgram, binaryKey);
+		}
 	}
 
-	for (const auto& shader : shaders)
+	linkState = LinkState::Idle;
+	Reflect();
+
+	for (const auto& [name, binding] : blockBindings)
 	{
-		glDetachShader(shaderProgram, dynamic_cast<CStdGLShader*>(shader)->GetHandle());
+		SetUniformBlockBinding(name, binding);
 	}
 
-	shaders.clear();
+	blockBindings.clear();
 }
 
-void CStdGLShaderProgram::Clear()
+bool CStdGLShaderProgram::EnableParallelCompile()
 {
-	for (const auto& shader : shaders)
+	using MaxShaderCompilerThreadsProc = void (APIENTRY *)(GLuint count);
+
+	// The ARB extension predates the KHR one, both share the enums
+	static constexpr std::pair<const char*, const char*> Extensions[]
+	{
+		{"GL_KHR_parallel_shader_compile", "glMaxShaderCompilerThreadsKHR"},
+		{"GL_ARB_parallel_shader_compile", "glMaxShaderCompilerThreadsARB"}
+	};
+
+	for (const auto& [extension, function] : Extensions)
 	{
-		glDetachShader(shaderProgram, dynamic_cast<CStdGLShader*>(shader)->GetHandle());
+		if (glfwExtensionSupported(extension))
+		{
+			if (const auto maxShaderCompilerThreads = reinterpret_cast<MaxShaderCompilerThreadsProc>(glfwGetProcAddress(function)))
+			{
+				maxShaderCompilerThreads(0xFFFFFFFF);
+			}
+
+			parallelCompile = true;
+			return true;
+		}
 	}
 
+	return false;
+}
+
+void CStdGLShaderProgram::Clear()
+{
 	if (shaderProgram)
 	{
+		CStdGLState::OnDeleteProgram(shaderProgram);
 		glDeleteProgram(shaderProgram);
 		shaderProgram = 0;
 	}
 
 	attributeLocations.clear();
-	uniformLocations.clear();
+	uniforms.clear();
+	linkState = LinkState::Idle;
+	attachedShaders.clear();
+	blockBindings.clear();
 
 	CStdShaderProgram::Clear();
 }
@@ -271,51 +621,129 @@ void CStdGLShaderProgram::EnsureProgram()
 	assert(shaderProgram);
 }
 
-bool CStdGLShaderProgram::SetUniform(const std::string& key, const glm::vec2& value)
+bool CStdGLShaderProgram::SetUniform(const std::string_view key, const glm::vec2& value)
 {
 	return SetUniform(key, glUniform2fv, 1, glm::value_ptr(value));
 }
 
-bool CStdGLShaderProgram::SetUniform(const std::string& key, const glm::vec3& value)
+bool CStdGLShaderProgram::SetUniform(const std::string_view key, const glm::vec3& value)
 {
 	return SetUniform(key, glUniform3fv, 1, glm::value_ptr(value));
 }
 
-bool CStdGLShaderProgram::SetUniform(const std::string& key, const glm::vec4& value)
+bool CStdGLShaderProgram::SetUniform(const std::string_view key, const glm::vec4& value)
 {
 	return SetUniform(key, glUniform4fv, 1, glm::value_ptr(value));
 }
 
-bool CStdGLShaderProgram::SetUniform(const std::string& key, const glm::mat4& value)
+bool CStdGLShaderProgram::SetUniform(const std::string_view key, const glm::mat4& value)
 {
 	return SetUniform(key, glUniformMatrix4fv, 1, false, glm::value_ptr(value));
 }
 
-void CStdGLShaderProgram::SetObjectLabel(std::string_view label)
+GLint CStdGLShaderProgram::GetSamplerUnit(const std::string_view key) const
 {
-	glObjectLabel(GL_PROGRAM, shaderProgram, label.size(), label.data());
+	const Uniform *uniform{FindUniform(key)};
+	return uniform ? uniform->unit : -1;
 }
 
-bool CStdGLShaderProgram::AddShaderInt(CStdShader* shader)
+// Blocks the linker dropped are left alone
+bool CStdGLShaderProgram::SetUniformBlockBinding(const std::string& name, const GLuint binding)
 {
-	if (auto* s = dynamic_cast<CStdGLShader*>(shader); s)
+	assert(shaderProgram);
+
+	if (IsLinkPending())
 	{
-		glAttachShader(shaderProgram, s->GetHandle());
+		blockBindings.emplace_back(name, binding);
 		return true;
 	}
 
-	return false;
+	const GLuint index{glGetUniformBlockIndex(shaderProgram, name.c_str())};
+	if (index == GL_INVALID_INDEX)
+	{
+		return false;
+	}
+
+	glUniformBlockBinding(shaderProgram, index, binding);
+	return true;
+}
+
+// Names and locations of the active uniforms, members of uniform blocks have no location and are skipped.
+// The unit of each sampler is read once here, the shaders assign it with layout(binding).
+void CStdGLShaderProgram::Reflect()
+{
+	uniforms.clear();
+
+	GLint count{0};
+	glGetProgramInterfaceiv(shaderProgram, GL_UNIFORM, GL_ACTIVE_RESOURCES, &count);
+	uniforms.reserve(count);
+
+	static constexpr GLenum Properties[]{GL_NAME_LENGTH, GL_TYPE, GL_LOCATION, GL_BLOCK_INDEX};
+	for (GLint i{0}; i < count; ++i)
+	{
+		GLint values[std::size(Properties)];
+		glGetProgramResourceiv(shaderProgram, GL_UNIFORM, i, std::size(Properties), Properties, std::size(values), nullptr, values);
+		if (values[3] != -1)
+		{
+			continue;
+		}
+
+		// The length includes the terminator
+		std::string name(values[0] - 1, '\0');
+		glGetProgramResourceName(shaderProgram, GL_UNIFORM, i, values[0], nullptr, name.data());
+
+		Uniform uniform{std::move(name), static_cast<GLenum>(values[1]), values[2], -1};
+		switch (uniform.type)
+		{
+		case GL_SAMPLER_2D:
+		case GL_INT_SAMPLER_2D:
+		case GL_UNSIGNED_INT_SAMPLER_2D:
+			glGetUniformiv(shaderProgram, uniform.location, &uniform.unit);
+			break;
+		}
+
+		uniforms.push_back(std::move(uniform));
+	}
+
+	std::sort(uniforms.begin(), uniforms.end(), [](const Uniform &first, const Uniform &second)
+	{
+		return first.name < second.name;
+	});
+}
+
+const CStdGLShaderProgram::Uniform *CStdGLShaderProgram::FindUniform(const std::string_view key) const
+{
+	assert(!IsLinkPending());
+
+	// The group is compared as a prefix, a grouped lookup does not allocate either
+	const auto it = std::lower_bound(uniforms.begin(), uniforms.end(), key, [this](const Uniform &uniform, const std::string_view key)
+	{
+		return CompareGroupedName(uniform.name, group, key) < 0;
+	});
+
+	return it != uniforms.end() && CompareGroupedName(it->name, group, key) == 0 ? &*it : nullptr;
+}
+
+void CStdGLShaderProgram::SetObjectLabel(std::string_view label)
+{
+	glObjectLabel(GL_PROGRAM, shaderProgram, label.size(), label.data());
+}
+
+// Attached by Link, which compiles the shader first unless the program comes from the binary cache
+bool CStdGLShaderProgram::AddShaderInt(CStdShader* shader)
+{
+	return dynamic_cast<CStdGLShader*>(shader);
 }
 
 void CStdGLShaderProgram::OnSelect()
 {
 	assert(shaderProgram);
-	glUseProgram(shaderProgram);
+	CStdGLState::UseProgram(shaderProgram);
 }
 
 void CStdGLShaderProgram::OnDeselect()
 {
-	glUseProgram(GL_NONE);
+	CStdGLState::UseProgram(GL_NONE);
 }
 
 void CStdRectangle::GenerateGeometry(std::vector<GLfloat> &vertices, std::vector<GLuint> &elements, std::vector<GLfloat> &normals, std::vector<GLfloat> &textureCoordinates)
@@ -343,67 +771,153 @@ void CStdRectangle::GenerateGeometry(std::vector<GLfloat> &vertices, std::vector
 CStdTexture::CStdTexture(const std::int32_t width, const std::int32_t height, const GLenum internalFormat, const GLenum format, const GLenum type, void *const data)
 	: width{width}, height{height}, internalFormat{internalFormat}, format{format}, type{type}
 {
-	const auto target = GetTarget();
-
-	glGenTextures(1, &texture);
-	glBindTexture(target, texture);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glCreateTextures(GetTarget(), 1, &texture);
+	glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTextureStorage2D(texture, 1, internalFormat, width, height);
 
-	SetData(data);
+	if (data)
+	{
+		SetData(data);
+	}
 }
 
 CStdTexture::~CStdTexture()
 {
 	if (texture)
 	{
+		CStdGLState::OnDeleteTexture(texture);
 		glDeleteTextures(1, &texture);
 	}
 }
 
 void CStdTexture::Bind(GLenum offset) const
 {
-	glActiveTexture(GL_TEXTURE0 + offset);
+	CStdGLState::BindTexture(offset, GetTarget(), texture);
+}
 
-	glBindTexture(GetTarget(), texture);
+void CStdTexture::BindImage(const GLuint unit, const GLenum access) const
+{
+	glBindImageTexture(unit, texture, 0, GL_FALSE, 0, access, internalFormat);
 }
 
 void CStdTexture::SetData(void *const data) const
 {
-	glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, nullptr);
+	glTextureSubImage2D(texture, 0, 0, 0, width, height, format, type, data);
+}
+
+void CStdTexture::Clear() const
+{
+	glClearTexImage(texture, 0, format, type, nullptr);
+}
+
+CStdBuffer::CStdBuffer(const GLsizeiptr size, const GLbitfield flags, const void *const data)
+	: size{size}
+{
+	glCreateBuffers(1, &buffer);
+	glNamedBufferStorage(buffer, size, data, flags);
+}
+
+CStdBuffer::~CStdBuffer()
+{
+	if (buffer)
+	{
+		glDeleteBuffers(1, &buffer);
+	}
+}
+
+void CStdBuffer::BindBase(const GLenum target, const GLuint index) const
+{
+	glBindBufferBase(target, index, buffer);
+}
+
+void CStdBuffer::SetData(const GLintptr offset, const GLsizeiptr dataSize, const void *const data) const
+{
+	glNamedBufferSubData(buffer, offset, dataSize, data);
+}
+
+void CStdBuffer::GetData(const GLintptr offset, const GLsizeiptr dataSize, void *const data) const
+{
+	glGetNamedBufferSubData(buffer, offset, dataSize, data);
+}
+
+void *CStdBuffer::Map(const GLintptr offset, const GLsizeiptr length, const GLbitfield access) const
+{
+	return glMapNamedBufferRange(buffer, offset, length, access);
 }
 
-CStdFramebuffer::CStdFramebuffer(const std::int32_t width, const std::int32_t height)
-	: colorAttachment{width, height, InternalFormat, Format, Type}
+CStdFence::~CStdFence()
 {
-	glGenFramebuffers(1, &FBO);
-	colorAttachment.Bind(0);
-	glBindFramebuffer(GL_FRAMEBUFFER, FBO);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, colorAttachment.GetTarget(), colorAttachment.GetTexture(), 0);
+	if (sync)
+	{
+		glDeleteSync(sync);
+	}
+}
 
-	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+void CStdFence::Insert()
+{
+	if (sync)
 	{
-		throw std::runtime_error{ "glCheckFramebufferStatus" };
+		glDeleteSync(sync);
 	}
 
-	glViewport(0, 0, width, height);
-	glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
-	glClear(GL_COLOR_BUFFER_BIT);
+	sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
 
-	glBindFramebuffer(GL_FRAMEBUFFER, GL_NONE);
+bool CStdFence::IsSignaled() const
+{
+	const GLenum status{glClientWaitSync(sync, GL_SYNC_FLUSH_COMMANDS_BIT, 0)};
+	return status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED;
+}
+
+void CStdFence::Wait() const
+{
+	// One second per wait, the flush bit only has to be set on the first one
+	static constexpr GLuint64 Timeout{1000000000};
+
+	GLbitfield flags{GL_SYNC_FLUSH_COMMANDS_BIT};
+	for (;;)
+	{
+		switch (glClientWaitSync(sync, flags, Timeout))
+		{
+		case GL_ALREADY_SIGNALED:
+		case GL_CONDITION_SATISFIED:
+			return;
+		case GL_WAIT_FAILED:
+			throw std::runtime_error{"glClientWaitSync"};
+		default:
+			flags = 0;
+			break;
+		}
+	}
+}
+
+CStdFramebuffer::CStdFramebuffer(const std::int32_t width, const std::int32_t height, const GLenum internalFormat, const GLenum format)
+	: colorAttachment{width, height, internalFormat, format, Type}
+{
+	glCreateFramebuffers(1, &FBO);
+	glNamedFramebufferTexture(FBO, GL_COLOR_ATTACHMENT0, colorAttachment.GetTexture(), 0);
+
+	if (glCheckNamedFramebufferStatus(FBO, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		throw std::runtime_error{ "glCheckNamedFramebufferStatus" };
+	}
+
+	colorAttachment.Clear();
 }
 
 CStdFramebuffer::~CStdFramebuffer()
 {
 	if (FBO)
 	{
+		CStdGLState::OnDeleteFramebuffer(FBO);
 		glDeleteFramebuffers(1, &FBO);
 	}
 }
 
 void CStdFramebuffer::Bind() const
 {
-	glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+	CStdGLState::BindFramebuffer(FBO);
 }
 
 void CStdFramebuffer::BindTexture(GLenum offset) const
@@ -413,7 +927,12 @@ void CStdFramebuffer::BindTexture(GLenum offset) const
 
 void CStdFramebuffer::Unbind() const
 {
-	glBindFramebuffer(GL_FRAMEBUFFER, GL_NONE);
+	CStdGLState::BindFramebuffer(GL_NONE);
+}
+
+void CStdFramebuffer::Clear() const
+{
+	colorAttachment.Clear();
 }
 
 /*
@@ -451,8 +970,8 @@ void CStdFramebuffer::Resize(std::int32_t newWidth, std::int32_t newHeight, CStd
 }
 */
 
-CStdSwappableFramebuffer::CStdSwappableFramebuffer(const std::int32_t width, const std::int32_t height)
-	: buffer1{width, height}, buffer2{width, height}, front{&buffer1}, back{&buffer2}
+CStdSwappableFramebuffer::CStdSwappableFramebuffer(const std::int32_t width, const std::int32_t height, const GLenum internalFormat, const GLenum format)
+	: buffer1{width, height, internalFormat, format}, buffer2{width, height, internalFormat, format}, front{&buffer1}, back{&buffer2}
 {
 }
 
@@ -8,6 +8,65 @@
 #include <array>
 #include <string_view>
 #include <unordered_map>
+#include <vector>
+
+class CStdProgramBinaryCache;
+
+// Source of a file of the Shader directory by name, with its #include "file" directives resolved.
+// Comes from the copy EmbedShaders.py built into the executable unless SetShaderDirectory was called.
+std::string LoadShader(std::string_view name);
+// Reads the shaders from disk from now on, for editing them without a rebuild
+void SetShaderDirectory(const std::string& directory);
+
+// Shadow copy of the bound program, framebuffer, viewport, vertex array and 2D textures, calls that would not change them are dropped.
+// The wrappers below bind through it. A raw glBind*, glUseProgram or glViewport elsewhere has to be followed by Invalidate.
+class CStdGLState
+{
+public:
+	// GL calls of the wrappers since the last ResetCounters, a filtered call never reached the driver
+	struct Counters
+	{
+		std::size_t issued{0};
+		std::size_t filtered{0};
+	};
+
+	static constexpr inline std::size_t NumTextureUnits = 32;
+
+public:
+	static void UseProgram(GLuint program);
+	static void BindFramebuffer(GLuint framebuffer);
+	static void Viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+	static void BindVertexArray(GLuint vertexArray);
+	// Binds for sampling only. A filtered call does not make unit the active one, so glTex* calls that edit "the bound texture"
+	// may hit another texture afterwards. Textures are created and edited through the DSA calls of CStdTexture instead.
+	static void BindTexture(GLuint unit, GLenum target, GLuint texture);
+
+	// Deleting an object resets the bindings it had, and the driver may hand out its name again
+	static void OnDeleteProgram(GLuint program);
+	static void OnDeleteFramebuffer(GLuint framebuffer);
+	static void OnDeleteVertexArray(GLuint vertexArray);
+	static void OnDeleteTexture(GLuint texture);
+
+	// Forgets everything, the next call of each kind goes through
+	static void Invalidate();
+
+	static const Counters &GetCounters() { return counters; }
+	static void ResetCounters() { counters = {}; }
+
+private:
+	static bool Filter(bool unchanged);
+
+private:
+	static constexpr inline GLuint Unknown = ~GLuint{0};
+
+	static GLuint program;
+	static GLuint framebuffer;
+	static glm::ivec4 viewport;
+	static GLuint vertexArray;
+	static GLuint activeTexture;
+	static std::array<GLuint, NumTextureUnits> textures;
+	static Counters counters;
+};
 
 // shader
 class CStdShader
@@ -40,6 +99,8 @@ public:
 	void UnsetMacro(const std::string& key);
 	void SetSource(const std::string& source);
 	void AddInclude(const std::string& source);
+	// Emitted right after #version, ahead of the macros and includes
+	void AddExtension(const std::string& name);
 	void SetType(Type type);
 
 	virtual void Compile() = 0;
@@ -55,6 +116,7 @@ protected:
 	Type type;
 	std::string source;
 	std::vector<std::string> includes;
+	std::vector<std::string> extensions;
 	std::unordered_map<std::string, std::string> macros;
 	std::string errorMessage;
 };
@@ -64,16 +126,25 @@ class CStdGLShader : public CStdShader
 public:
 	using CStdShader::CStdShader;
 
+	// Only prepares the source, the GL shader is compiled by the first Link that does not find its program in the binary cache
 	void Compile() override;
+	// Hands the source to the driver without waiting for the result, see CheckStatus
+	void Submit();
 	void Clear() override;
 
+	// Throws the info log if the shader failed to compile, blocks until the compile is done
+	static void CheckStatus(GLuint shader);
+
 	virtual int64_t GetHandle() const override { return shader; }
+	// The source as handed to the driver, with the extensions, macros and includes
+	const std::string &GetPreparedSource() const { return preparedSource; }
 
 protected:
-	virtual void PrepareSource();
+	virtual std::string PrepareSource() const;
 
 protected:
 	GLuint shader = 0;
+	std::string preparedSource;
 };
 
 class CStdShaderProgram
@@ -116,6 +187,42 @@ protected:
 	static CStdShaderProgram* currentShaderProgram;
 };
 
+// Typed location of a uniform, set through glProgramUniform* without selecting the program.
+// Obtained from CStdGLShaderProgram::GetUniformHandle, which checks T against the type the program declares.
+template<typename T>
+class CStdUniformHandle
+{
+public:
+	CStdUniformHandle() : program{GL_NONE}, location{-1} {}
+	CStdUniformHandle(GLuint program, GLint location) : program{program}, location{location} {}
+
+public:
+	void Set(const T &value) const;
+	explicit operator bool() const { return location != -1; }
+
+	static GLenum GetType();
+
+private:
+	GLuint program;
+	GLint location;
+};
+
+template<> inline void CStdUniformHandle<float>::Set(const float &value) const { glProgramUniform1f(program, location, value); }
+template<> inline void CStdUniformHandle<GLint>::Set(const GLint &value) const { glProgramUniform1i(program, location, value); }
+template<> inline void CStdUniformHandle<bool>::Set(const bool &value) const { glProgramUniform1i(program, location, value); }
+template<> inline void CStdUniformHandle<glm::vec2>::Set(const glm::vec2 &value) const { glProgramUniform2fv(program, location, 1, glm::value_ptr(value)); }
+template<> inline void CStdUniformHandle<glm::vec4>::Set(const glm::vec4 &value) const { glProgramUniform4fv(program, location, 1, glm::value_ptr(value)); }
+template<> inline void CStdUniformHandle<glm::ivec2>::Set(const glm::ivec2 &value) const { glProgramUniform2iv(program, location, 1, glm::value_ptr(value)); }
+template<> inline void CStdUniformHandle<glm::ivec4>::Set(const glm::ivec4 &value) const { glProgramUniform4iv(program, location, 1, glm::value_ptr(value)); }
+
+template<> inline GLenum CStdUniformHandle<float>::GetType() { return GL_FLOAT; }
+template<> inline GLenum CStdUniformHandle<GLint>::GetType() { return GL_INT; }
+template<> inline GLenum CStdUniformHandle<bool>::GetType() { return GL_BOOL; }
+template<> inline GLenum CStdUniformHandle<glm::vec2>::GetType() { return GL_FLOAT_VEC2; }
+template<> inline GLenum CStdUniformHandle<glm::vec4>::GetType() { return GL_FLOAT_VEC4; }
+template<> inline GLenum CStdUniformHandle<glm::ivec2>::GetType() { return GL_INT_VEC2; }
+template<> inline GLenum CStdUniformHandle<glm::ivec4>::GetType() { return GL_INT_VEC4; }
+
 class CStdGLShaderProgram : public CStdShaderProgram
 {
 public:
@@ -123,7 +230,16 @@ public:
 
 	explicit operator bool() const override { return /*glIsProgram(*/shaderProgram/*)*/; }
 
+	// BeginLink and FinishLink in one go
 	void Link() override;
+	// Compiles the pending shaders and links without waiting for either, a driver with KHR_parallel_shader_compile
+	// works on several programs at once. Nothing but SetObjectLabel and SetUniformBlockBinding may be used before FinishLink.
+	void BeginLink();
+	// Polls the driver, always true without KHR_parallel_shader_compile
+	bool IsLinkComplete() const;
+	// Waits for the link if it still runs, throws its errors and reflects the uniforms
+	void FinishLink();
+	bool IsLinkPending() const { return linkState != LinkState::Idle; }
 	void Clear() override;
 
 	void EnsureProgram() override;
@@ -133,16 +249,48 @@ public:
 		return SetAttribute(key, &CStdGLShaderProgram::attributeLocations, glGetAttribLocation, function, args...);
 	}
 
-	template<typename Func, typename... Args> bool SetUniform(const std::string& key, Func function, Args... args)
+	template<typename Func, typename... Args> bool SetUniform(std::string_view key, Func function, Args... args)
 	{
-		return SetAttribute(key, &CStdGLShaderProgram::uniformLocations, glGetUniformLocation, function, args...);
+		assert(shaderProgram);
+
+		const Uniform *uniform{FindUniform(key)};
+		if (!uniform)
+		{
+			return false;
+		}
+
+		function(uniform->location, args...);
+		return true;
 	}
 
-	bool SetUniform(const std::string& key, float value) { return SetUniform(key, glUniform1f, value); }
-	bool SetUniform(const std::string& key, const glm::vec2& value);
-	bool SetUniform(const std::string& key, const glm::vec3& value);
-	bool SetUniform(const std::string& key, const glm::vec4& value);
-	bool SetUniform(const std::string& key, const glm::mat4& value);
+	bool SetUniform(std::string_view key, float value) { return SetUniform(key, glUniform1f, value); }
+	bool SetUniform(std::string_view key, const glm::vec2& value);
+	bool SetUniform(std::string_view key, const glm::vec3& value);
+	bool SetUniform(std::string_view key, const glm::vec4& value);
+	bool SetUniform(std::string_view key, const glm::mat4& value);
+
+	// Resolved once, setting it later neither looks up the name nor needs the program to be selected.
+	// A uniform the linker dropped gives an empty handle, whose Set does nothing.
+	template<typename T> CStdUniformHandle<T> GetUniformHandle(std::string_view key) const
+	{
+		const Uniform *uniform{FindUniform(key)};
+		if (!uniform)
+		{
+			return {};
+		}
+
+		if (uniform->type != CStdUniformHandle<T>::GetType())
+		{
+			throw Exception{"Uniform " + std::string{key} + " does not have the requested type"};
+		}
+
+		return {shaderProgram, uniform->location};
+	}
+
+	// Texture unit of a sampler as set by layout(binding), -1 if the program has no such sampler
+	GLint GetSamplerUnit(std::string_view key) const;
+
+	bool SetUniformBlockBinding(const std::string& name, GLuint binding);
 
 	void EnterGroup(const std::string& name) { group.assign(name).append("."); }
 	void LeaveGroup() { group.clear(); }
@@ -151,11 +299,37 @@ public:
 
 	virtual int64_t GetProgram() const override { return shaderProgram; }
 
+	// Programs linked while a cache is set are loaded from it if their sources did not change, nullptr disables it
+	static void SetBinaryCache(CStdProgramBinaryCache *cache) { binaryCache = cache; }
+	static const CStdProgramBinaryCache *GetBinaryCache() { return binaryCache; }
+	// Asks the driver for as many compiler threads as it likes, once a context is current. False without the extension.
+	static bool EnableParallelCompile();
+
 protected:
 	bool AddShaderInt(CStdShader* shader) override;
 	void OnSelect() override;
 	void OnDeselect() override;
 
+	// Active uniforms outside of blocks, sorted by name
+	struct Uniform
+	{
+		std::string name;
+		GLenum type;
+		GLint location;
+		GLint unit;
+	};
+
+	enum class LinkState : uint8_t
+	{
+		Idle,
+		Linking,
+		// Loaded from the binary cache, only the reflection is left
+		Cached
+	};
+
+	void Reflect();
+	const Uniform *FindUniform(std::string_view key) const;
+
 	using Locations = std::unordered_map<std::string, GLint>;
 	template<typename MapFunc, typename SetFunc, typename... Args> bool SetAttribute(const std::string& key, Locations CStdGLShaderProgram::* locationPointer, MapFunc mapFunction, SetFunc setFunction, Args... args)
 	{
@@ -190,9 +364,18 @@ protected:
 	GLuint shaderProgram{ 0 };
 
 	Locations attributeLocations;
-	Locations uniformLocations;
+	std::vector<Uniform> uniforms;
 
 	std::string group;
+
+	LinkState linkState{LinkState::Idle};
+	std::uint64_t binaryKey{0};
+	std::vector<GLuint> attachedShaders;
+	// Requested while the link was pending, applied by FinishLink
+	std::vector<std::pair<std::string, GLuint>> blockBindings;
+
+	static CStdProgramBinaryCache *binaryCache;
+	static bool parallelCompile;
 };
 
 template<typename Class>
@@ -202,6 +385,7 @@ public:
 	CStdVAOObject() = default;
 	virtual ~CStdVAOObject()
 	{
+		CStdGLState::OnDeleteVertexArray(VAO);
 		glDeleteVertexArrays(1, &VAO);
 		glDeleteBuffers(VBO.size(), VBO.data());
 	}
@@ -209,7 +393,7 @@ public:
 public:
 	void Bind() const
 	{
-		glBindVertexArray(VAO);
+		CStdGLState::BindVertexArray(VAO);
 	}
 	void Draw() const
 	{
@@ -223,7 +407,7 @@ protected:
 		glGenVertexArrays(1, &VAO);
 		glGenBuffers(VBO.size(), VBO.data());
 
-		glBindVertexArray(VAO);
+		CStdGLState::BindVertexArray(VAO);
 		glBindBuffer(GL_ARRAY_BUFFER, VBO[0]);
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, VBO[VBO.size() - 1]);
 
@@ -252,7 +436,7 @@ protected:
 		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(GLfloat), nullptr);
 		glEnableVertexAttribArray(2);
 
-		glBindVertexArray(GL_NONE);
+		CStdGLState::BindVertexArray(GL_NONE);
 		glBindBuffer(GL_ARRAY_BUFFER, GL_NONE);
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, GL_NONE);
 	}
@@ -279,6 +463,7 @@ protected:
 	virtual void GenerateGeometry(std::vector<GLfloat> &vertices, std::vector<GLuint> &elements, std::vector<GLfloat> &normals, std::vector<GLfloat> &textureCoordinates) override;
 };
 
+// Immutable storage created through direct state access, neither creating nor filling a texture touches the bindings
 class CStdTexture
 {
 public:
@@ -312,10 +497,18 @@ public:
 
 public:
 	void Bind(GLenum offset) const;
+	void BindImage(GLuint unit, GLenum access) const;
+	// data holds width * height texels of format and type
 	void SetData(void *const data) const;
+	// Zeroes the texture
+	void Clear() const;
 	GLenum GetTarget() const { return GL_TEXTURE_2D; }
 
 	GLuint GetTexture() const { return texture; }
+	std::int32_t GetWidth() const { return width; }
+	std::int32_t GetHeight() const { return height; }
+	GLenum GetInternalFormat() const { return internalFormat; }
+	GLenum GetFormat() const { return format; }
 
 protected:
 	GLuint texture{GL_NONE};
@@ -328,11 +521,95 @@ protected:
 
 static_assert(std::is_move_constructible_v<CStdTexture>);
 
+// Immutable GL buffer object, used for shader storage and uniform blocks
+class CStdBuffer
+{
+public:
+	CStdBuffer() : buffer{GL_NONE}, size{0} {}
+	CStdBuffer(GLsizeiptr size, GLbitfield flags = GL_DYNAMIC_STORAGE_BIT, const void *data = nullptr);
+	CStdBuffer(const CStdBuffer &) = delete;
+	CStdBuffer(CStdBuffer &&other) : CStdBuffer{}
+	{
+		swap(*this, other);
+	}
+	~CStdBuffer();
+
+	CStdBuffer &operator=(const CStdBuffer &other) = delete;
+	CStdBuffer &operator=(CStdBuffer &&other)
+	{
+		swap(*this, other);
+		return *this;
+	}
+
+	friend void swap(CStdBuffer &first, CStdBuffer &second)
+	{
+		using std::swap;
+
+		swap(first.buffer, second.buffer);
+		swap(first.size, second.size);
+	}
+
+public:
+	void BindBase(GLenum target, GLuint index) const;
+	void SetData(GLintptr offset, GLsizeiptr dataSize, const void *data) const;
+	void GetData(GLintptr offset, GLsizeiptr dataSize, void *data) const;
+	// The mapping stays valid until the buffer is deleted if access contains GL_MAP_PERSISTENT_BIT
+	void *Map(GLintptr offset, GLsizeiptr length, GLbitfield access) const;
+
+	GLuint GetBuffer() const { return buffer; }
+	GLsizeiptr GetSize() const { return size; }
+
+protected:
+	GLuint buffer;
+	GLsizeiptr size;
+};
+
+// Sync object that can be polled without stalling the pipeline
+class CStdFence
+{
+public:
+	CStdFence() : sync{nullptr} {}
+	CStdFence(const CStdFence &) = delete;
+	CStdFence(CStdFence &&other) : CStdFence{}
+	{
+		swap(*this, other);
+	}
+	~CStdFence();
+
+	CStdFence &operator=(const CStdFence &other) = delete;
+	CStdFence &operator=(CStdFence &&other)
+	{
+		swap(*this, other);
+		return *this;
+	}
+
+	friend void swap(CStdFence &first, CStdFence &second)
+	{
+		using std::swap;
+
+		swap(first.sync, second.sync);
+	}
+
+public:
+	// Replaces a previously inserted fence
+	void Insert();
+	// Flushes the command stream so the fence is guaranteed to signal eventually
+	bool IsSignaled() const;
+	// Blocks until the fence has signaled, for callers that cannot go on without the result
+	void Wait() const;
+
+	explicit operator bool() const { return sync; }
+
+protected:
+	GLsync sync;
+};
+
+// One color attachment, zeroed on creation. Like CStdTexture it is set up without binding anything or changing the viewport.
 class CStdFramebuffer
 {
 public:
 	CStdFramebuffer() : colorAttachment{}, FBO{GL_NONE} {}
-	CStdFramebuffer(std::int32_t width, std::int32_t height);
+	CStdFramebuffer(std::int32_t width, std::int32_t height, GLenum internalFormat = InternalFormat, GLenum format = Format);
 	~CStdFramebuffer();
 
 	CStdFramebuffer(CStdFramebuffer &&other) : CStdFramebuffer{}
@@ -357,15 +634,21 @@ public:
 	void Bind() const;
 	void BindTexture(GLenum offset) const;
 	void Unbind() const;
+	// Does not bind the framebuffer
+	void Clear() const;
 	const CStdTexture &GetTexture() const { return colorAttachment; }
+	std::int32_t GetWidth() const { return colorAttachment.GetWidth(); }
+	std::int32_t GetHeight() const { return colorAttachment.GetHeight(); }
 
 	//void Resize(std::int32_t newWidth, std::int32_t newHeight, CStdGLShaderProgram &copyShader, CStdRectangle &rectangle);
 
-private:
-	static constexpr inline auto InternalFormat = GL_RG16F;
-	static constexpr inline auto Format = GL_RG;
-	static constexpr inline auto Type = GL_FLOAT;
+public:
+	// Default color attachment format of the simulation fields
+	static constexpr inline GLenum InternalFormat = GL_RG16F;
+	static constexpr inline GLenum Format = GL_RG;
+	static constexpr inline GLenum Type = GL_FLOAT;
 
+private:
 	CStdTexture colorAttachment;
 	GLuint FBO;
 };
@@ -374,7 +657,7 @@ class CStdSwappableFramebuffer
 {
 public:
 	CStdSwappableFramebuffer() : buffer1{}, buffer2{}, front{nullptr}, back{nullptr} {}
-	CStdSwappableFramebuffer(std::int32_t width, std::int32_t height);
+	CStdSwappableFramebuffer(std::int32_t width, std::int32_t height, GLenum internalFormat = CStdFramebuffer::InternalFormat, GLenum format = CStdFramebuffer::Format);
 	CStdSwappableFramebuffer(CStdSwappableFramebuffer &&other) : CStdSwappableFramebuffer{}
 	{
 		swap(*this, other);
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <array>
+#include <functional>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Shader.h"
+
+// Specializations of one pass, built on demand. Every axis is a macro the shader tests with #if defined(NAME):
+// the generic program leaves them unset and reads uniforms instead, a variant bakes the values in as constants.
+// Get hands out the generic program until the variant it asked for is linked. Poll finishes the links, once per frame,
+// so a new variant does not stall the frame that needs it. Without KHR_parallel_shader_compile the Poll after the request still waits for the driver.
+// Payload is constructed from the linked program, usually the uniform handles of the pass.
+template<typename Payload>
+class CStdShaderVariants
+{
+public:
+	static constexpr inline std::size_t MaxAxes{4};
+
+	// Name and value of every axis of one variant, empty for the generic program
+	using Macros = std::vector<std::pair<std::string, std::string>>;
+	// Adds the shaders with the macros set and starts linking with BeginLink
+	using BuildFunction = std::function<void(CStdGLShaderProgram &program, const Macros &macros)>;
+	// One value per axis, in the order of the constructor, the rest stays 0
+	using Values = std::array<GLint, MaxAxes>;
+
+	struct Variant
+	{
+		CStdGLShaderProgram program;
+		Payload payload;
+	};
+
+public:
+	explicit CStdShaderVariants(std::vector<std::string> axes) : axes{std::move(axes)}
+	{
+		if (this->axes.size() > MaxAxes)
+		{
+			throw std::invalid_argument{"Too many variant axes"};
+		}
+	}
+
+public:
+	// Starts linking the generic program, the caller finishes it with its other programs and then calls FinishLoad
+	CStdGLShaderProgram &Load(BuildFunction buildFunction)
+	{
+		build = std::move(buildFunction);
+		Clear();
+		build(generic.program, {});
+		return generic.program;
+	}
+	void FinishLoad() { generic.payload = Payload{generic.program}; }
+
+	// The variant for values once it is linked, the generic program until then
+	Variant &Get(const Values &values)
+	{
+		const auto it = variants.find(values);
+		if (it != variants.end())
+		{
+			return it->second->ready ? it->second->variant : generic;
+		}
+
+		Macros macros;
+		for (std::size_t i{0}; i < axes.size(); ++i)
+		{
+			macros.emplace_back(axes[i], std::to_string(values[i]));
+		}
+
+		auto entry = std::make_unique<Entry>();
+		build(entry->variant.program, macros);
+		variants.emplace(values, std::move(entry));
+		++pending;
+		return generic;
+	}
+
+	void Poll()
+	{
+		for (auto it = variants.begin(); pending > 0 && it != variants.end(); ++it)
+		{
+			Entry &entry{*it->second};
+			if (!entry.ready && entry.variant.program.IsLinkComplete())
+			{
+				entry.variant.program.FinishLink();
+				entry.variant.payload = Payload{entry.variant.program};
+				entry.ready = true;
+				--pending;
+			}
+		}
+	}
+
+	// Drops the variants, for axes that went stale like the grid size after a resize
+	void Clear()
+	{
+		variants.clear();
+		pending = 0;
+	}
+
+	std::size_t GetCount() const { return variants.size(); }
+
+private:
+	struct Entry
+	{
+		Variant variant;
+		bool ready{false};
+	};
+
+private:
+	std::vector<std::string> axes;
+	BuildFunction build;
+	Variant generic;
+	std::map<Values, std::unique_ptr<Entry>> variants;
+	std::size_t pending{0};
+};
@@ -0,0 +1,78 @@
+#include "SpectralSolver.h"
+
+#include <algorithm>
+#include <cmath>
+
+void CStdSpectralSolver::Solve(CStdGrid<float> &solution, const CStdGrid<float> &rightHandSide, const float alpha, const float beta)
+{
+	const std::int32_t width{solution.GetWidth()};
+	const std::int32_t height{solution.GetHeight()};
+	EnsureTransforms(width, height);
+
+	const float *const source{rightHandSide.GetData().data()};
+	float *const coefficients{spectrum.GetData().data()};
+	float *const result{solution.GetData().data()};
+
+	// Lines are transformed in pairs, see CStdDHT
+	const std::int32_t numRowPairs{(height + 1) / 2};
+	const std::int32_t numColumnPairs{(width + 1) / 2};
+
+	threadPool.ParallelFor(0, numRowPairs, [&](const std::int32_t begin, const std::int32_t end)
+	{
+		CStdDHT::Workspace workspace;
+		for (std::int32_t pair{begin}; pair < end; ++pair)
+		{
+			const std::int32_t y{2 * pair};
+			rowTransform->Forward(source + y * width, 1, coefficients + y * width, 1, width, std::min(height - y, 2), workspace);
+		}
+	});
+
+	threadPool.ParallelFor(0, numColumnPairs, [&](const std::int32_t begin, const std::int32_t end)
+	{
+		static constexpr float Pi{3.14159265f};
+
+		CStdDHT::Workspace workspace;
+		for (std::int32_t pair{begin}; pair < end; ++pair)
+		{
+			const std::int32_t x{2 * pair};
+			const std::int32_t numColumns{std::min(width - x, 2)};
+			float *const column{coefficients + x};
+			columnTransform->Forward(column, width, column, width, 1, numColumns, workspace);
+
+			for (std::int32_t i{0}; i < numColumns; ++i)
+			{
+				const float rowEigenvalue{beta - 2.0f * std::cos(2.0f * Pi * (x + i) / width)};
+				for (std::int32_t y{0}; y < height; ++y)
+				{
+					const float eigenvalue{rowEigenvalue - 2.0f * std::cos(2.0f * Pi * y / height)};
+					float &value{column[y * width + i]};
+					value = std::abs(eigenvalue) > 1e-6f ? alpha * value / eigenvalue : 0.0f;
+				}
+			}
+
+			columnTransform->Inverse(column, width, column, width, 1, numColumns, workspace);
+		}
+	});
+
+	threadPool.ParallelFor(0, numRowPairs, [&](const std::int32_t begin, const std::int32_t end)
+	{
+		CStdDHT::Workspace workspace;
+		for (std::int32_t pair{begin}; pair < end; ++pair)
+		{
+			const std::int32_t y{2 * pair};
+			rowTransform->Inverse(coefficients + y * width, 1, result + y * width, 1, width, std::min(height - y, 2), workspace);
+		}
+	});
+}
+
+void CStdSpectralSolver::EnsureTransforms(const std::int32_t width, const std::int32_t height)
+{
+	if (spectrum.GetWidth() == width && spectrum.GetHeight() == height)
+	{
+		return;
+	}
+
+	rowTransform = std::make_unique<CStdDHT>(width);
+	columnTransform = std::make_unique<CStdDHT>(height);
+	spectrum = CStdGrid<float>{width, height};
+}
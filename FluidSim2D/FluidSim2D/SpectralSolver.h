@@ -0,0 +1,31 @@
+#pragma once
+
+#include <memory>
+
+#include "FFT.h"
+#include "Grid.h"
+#include "ThreadPool.h"
+
+// Direct solver for the systems SolvePoissonSystem handles on a plain rectangle:
+//   beta * x - (xL + xR + xB + xT) = alpha * b
+// With wrapping neighbours, like every other solver, the 2D Hartley transform diagonalizes the operator, mode (k, l) has the eigenvalue
+//   beta - 2 cos(2 pi k / width) - 2 cos(2 pi l / height)
+// so one forward transform, a division and one inverse transform solve the system exactly in O(N log N).
+class CStdSpectralSolver
+{
+public:
+	explicit CStdSpectralSolver(CStdThreadPool &threadPool) : threadPool{threadPool} {}
+
+public:
+	// The singular constant mode of the pressure system (beta == 4) is set to zero, the result has zero mean
+	void Solve(CStdGrid<float> &solution, const CStdGrid<float> &rightHandSide, float alpha, float beta);
+
+private:
+	void EnsureTransforms(std::int32_t width, std::int32_t height);
+
+private:
+	CStdThreadPool &threadPool;
+	std::unique_ptr<CStdDHT> rowTransform;
+	std::unique_ptr<CStdDHT> columnTransform;
+	CStdGrid<float> spectrum;
+};
@@ -0,0 +1,364 @@
+#include "StencilBenchmark.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "GLFluidSolver.h"
+#include "Shader.h"
+
+namespace
+{
+	struct StencilPass
+	{
+		const char *label;
+		const char *shader;
+		// simulation.comp pass of the compute backend
+		const char *kernel;
+		const char *field;
+		bool scalar;
+		// Fields read besides the one that is written, for the bandwidth
+		std::size_t inputs;
+		// Texture instructions per fragment as the shaders are written, of the Filtered and TexelFetch variants and of the Gather variant.
+		// They are printed for reference only, nothing is measured or derived from them.
+		std::size_t expectedFetches;
+		std::size_t expectedGatherFetches;
+	};
+
+	constexpr StencilPass Passes[]{
+		{"jacobi (diffusion)", "jacobi", "SIMULATION_JACOBI", "x", false, 2, 5, 5},
+		{"jacobi (pressure)", "jacobi", "SIMULATION_JACOBI", "x", true, 2, 5, 3},
+		{"divergence", "divergence", "SIMULATION_DIVERGENCE", "field", false, 1, 4, 4},
+		{"gradient", "gradient", "SIMULATION_GRADIENT", "field", false, 1, 4, 2},
+		{"vorticity", "vorticity", "SIMULATION_VORTICITY", "velocity", false, 1, 4, 4}
+	};
+
+	// RG16F, the format of every field of the benchmark
+	constexpr double TexelBytes{4.0};
+
+	// Expected fetches per cell of the compute backend, it loads an 18x18 tile per 16x16 workgroup and every other input once
+	constexpr double TiledFetches{18.0 * 18.0 / (16.0 * 16.0)};
+
+	const char *GetName(const StencilFetch fetch)
+	{
+		switch (fetch)
+		{
+		case StencilFetch::TexelFetch:
+			return "texel-fetch";
+		case StencilFetch::Gather:
+			return "gather";
+		default:
+			return "filtered";
+		}
+	}
+
+	std::size_t ParseCount(const int argc, char *argv[], const std::string_view option, const std::size_t defaultCount)
+	{
+		for (int i{1}; i + 1 < argc; ++i)
+		{
+			if (std::string_view{argv[i]} == option && std::isdigit(static_cast<unsigned char>(argv[i + 1][0])))
+			{
+				return std::stoul(argv[i + 1]);
+			}
+		}
+
+		return defaultCount;
+	}
+
+	std::vector<glm::vec2> RandomField(const std::int32_t width, const std::int32_t height)
+	{
+		std::vector<glm::vec2> data(static_cast<std::size_t>(width) * height);
+		for (auto &value : data)
+		{
+			value = glm::vec2{std::rand(), std::rand()} / static_cast<float>(RAND_MAX);
+		}
+
+		return data;
+	}
+
+	std::vector<glm::vec2> ReadField(const CStdTexture &texture)
+	{
+		std::vector<glm::vec2> data(static_cast<std::size_t>(texture.GetWidth()) * texture.GetHeight());
+		glGetTextureImage(texture.GetTexture(), 0, GL_RG, GL_FLOAT, static_cast<GLsizei>(data.size() * sizeof(glm::vec2)), data.data());
+		return data;
+	}
+
+	void LinkComputeProgram(CStdGLShaderProgram &program, const std::string &source, const std::string &frameConstantsSource, const std::vector<std::pair<std::string, std::string>> &macros)
+	{
+		CStdGLShader shader{CStdShader::Type::Compute, source};
+		for (const auto &[name, value] : macros)
+		{
+			shader.SetMacro(name, value);
+		}
+		shader.AddInclude(frameConstantsSource);
+		shader.Compile();
+
+		program.AddShader(&shader);
+		program.Link();
+		CStdGLFluidSolver::BindFrameConstants(program);
+	}
+}
+
+int RunStencilBenchmark(const int argc, char *argv[], const std::int32_t width, const std::int32_t height)
+{
+	const std::size_t draws{ParseCount(argc, argv, "--benchmark-stencils", 500)};
+
+	std::cout << "Stencil benchmark: " << width << "x" << height << ", " << draws << " draws per pass\n"
+		<< "Renderer: " << glGetString(GL_RENDERER) << ", " << glGetString(GL_VERSION) << "\n";
+
+	std::vector<StencilFetch> variants{StencilFetch::Filtered, StencilFetch::TexelFetch};
+	if (CStdGLFluidSolver::SupportsGather())
+	{
+		variants.push_back(StencilFetch::Gather);
+	}
+	else
+	{
+		std::cout << "GL_ARB_gpu_shader5 is not supported, skipping gather\n";
+	}
+
+	// Unit grid scale, the time step and the other constants are not read by the stencil passes
+	const std::string frameConstantsSource{LoadShader("frame_constants.glsl")};
+	const CStdGLFluidSolver::FrameConstants constants{glm::vec2{1.0f / width, 1.0f / height}, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+	const CStdBuffer frameConstants{sizeof(constants), 0, &constants};
+	frameConstants.BindBase(GL_UNIFORM_BUFFER, CStdGLFluidSolver::FrameConstantsBinding);
+
+	CStdGLShader texCoordsShader{CStdShader::Type::Vertex, LoadShader("tex_coords.vert")};
+	texCoordsShader.AddInclude(frameConstantsSource);
+	texCoordsShader.Compile();
+
+	// The passes only depend on the data through the texture cache, any field will do
+	std::vector<glm::vec2> data{RandomField(width, height)};
+
+	CStdFramebuffer source{width, height};
+	source.GetTexture().SetData(data.data());
+	// A texture of its own, so Jacobi reads as many bytes as the bandwidth assumes
+	CStdFramebuffer rightHandSide{width, height};
+	rightHandSide.GetTexture().SetData(data.data());
+	CStdFramebuffer target{width, height};
+	CStdRectangle quad;
+
+	GLuint query;
+	glGenQueries(1, &query);
+	CStdGLState::Viewport(0, 0, width, height);
+
+	const std::string simulationSource{LoadShader("simulation.comp")};
+	const GLuint numGroupsX{(static_cast<GLuint>(width) + 15) / 16};
+	const GLuint numGroupsY{(static_cast<GLuint>(height) + 15) / 16};
+
+	// Runs submit once to warm up, then draws times inside a timer query.
+	// The bandwidth assumes every texel of the inputs is read from memory once and every texel of the target written once,
+	// so it only depends on the GL_TIME_ELAPSED time.
+	const auto measure = [&](const StencilPass &pass, const char *const variant, const double expectedFetches, const auto &submit)
+	{
+		submit();
+		glFinish();
+
+		glBeginQuery(GL_TIME_ELAPSED, query);
+		for (std::size_t i{0}; i < draws; ++i)
+		{
+			submit();
+		}
+		glEndQuery(GL_TIME_ELAPSED);
+
+		GLuint64 elapsed{0};
+		glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+
+		const double microseconds{elapsed / 1000.0 / draws};
+		const double fragments{static_cast<double>(width) * height};
+		const double fragmentsPerSecond{fragments / (microseconds * 1000.0)};
+		const double gigabytesPerSecond{(pass.inputs + 1) * TexelBytes * fragments / (microseconds * 1000.0)};
+
+		std::cout << std::left << std::setw(20) << pass.label << std::setw(14) << variant
+			<< std::setw(18) << std::setprecision(2) << expectedFetches
+			<< std::setw(12) << std::fixed << std::setprecision(1) << microseconds
+			<< std::setw(14) << std::setprecision(3) << fragmentsPerSecond
+			<< std::setprecision(1) << gigabytesPerSecond << "\n" << std::defaultfloat;
+	};
+
+	std::cout << std::left << std::setw(20) << "pass" << std::setw(14) << "variant" << std::setw(18) << "expected fetches" << std::setw(12) << "us/draw" << std::setw(14) << "Gfragments/s" << "GB/s\n";
+
+	for (const StencilPass &pass : Passes)
+	{
+		for (const StencilFetch variant : variants)
+		{
+			CStdGLShader shader{CStdShader::Type::Fragment, LoadShader(std::string{pass.shader} + ".frag")};
+			shader.AddExtension(CStdGLFluidSolver::SamplerBindingExtension);
+			CStdGLFluidSolver::SetStencilFetch(shader, variant);
+			shader.AddInclude(frameConstantsSource);
+			shader.Compile();
+
+			CStdGLShaderProgram program;
+			program.AddShader(&texCoordsShader);
+			program.AddShader(&shader);
+			program.Link();
+			CStdGLFluidSolver::BindFrameConstants(program);
+
+			program.Select();
+			program.SetUniform("alpha", glUniform1f, 1.0f);
+			program.SetUniform("beta", glUniform1f, 4.0f);
+			program.SetUniform("scalar", glUniform1i, pass.scalar);
+			CStdGLFluidSolver::BindTexture(program, pass.field, source.GetTexture());
+			CStdGLFluidSolver::BindTexture(program, "b", rightHandSide.GetTexture());
+
+			target.Bind();
+			quad.Bind();
+			measure(pass, GetName(variant), static_cast<double>(variant == StencilFetch::Gather ? pass.expectedGatherFetches : pass.expectedFetches), [&]
+			{
+				quad.Draw();
+			});
+		}
+
+		CStdGLShaderProgram program;
+		LinkComputeProgram(program, simulationSource, frameConstantsSource, {{pass.kernel, "1"}});
+
+		program.Select();
+		program.SetUniform("alpha", glUniform1f, 1.0f);
+		program.SetUniform("beta", glUniform1f, 4.0f);
+		program.SetUniform("omega", glUniform1f, 1.0f);
+		CStdGLFluidSolver::BindTexture(program, "field", source.GetTexture());
+		CStdGLFluidSolver::BindTexture(program, "b", rightHandSide.GetTexture());
+		target.GetTexture().BindImage(0, GL_READ_WRITE);
+
+		measure(pass, "compute-tiled", TiledFetches + (pass.inputs - 1), [&]
+		{
+			glDispatchCompute(numGroupsX, numGroupsY, 1);
+		});
+	}
+
+	glDeleteQueries(1, &query);
+
+	return 0;
+}
+
+
+int RunJacobiBlockingCheck(const int argc, char *argv[], const std::int32_t width, const std::int32_t height)
+{
+	static constexpr float Alpha{-1.0f};
+	static constexpr float Beta{4.0f};
+	// Relative rounding of one RG16F store
+	static constexpr float HalfEpsilon{1.0f / 2048.0f};
+
+	const std::size_t rounds{ParseCount(argc, argv, "--check-jacobi-blocking", 100)};
+	const GLuint numGroupsX{(static_cast<GLuint>(width) + 15) / 16};
+	const GLuint numGroupsY{(static_cast<GLuint>(height) + 15) / 16};
+
+	std::cout << "Jacobi blocking check: " << width << "x" << height << ", " << rounds << " timed rounds\n"
+		<< "Renderer: " << glGetString(GL_RENDERER) << ", " << glGetString(GL_VERSION) << "\n";
+
+	std::vector<glm::vec2> initialValue{RandomField(width, height)};
+	std::vector<glm::vec2> rightHandSide{RandomField(width, height)};
+
+	CStdFramebuffer b{width, height};
+	b.GetTexture().SetData(rightHandSide.data());
+	CStdSwappableFramebuffer plain{width, height};
+	CStdFramebuffer x{width, height};
+	x.GetTexture().SetData(initialValue.data());
+	CStdFramebuffer blocked{width, height};
+
+	const std::string simulationSource{LoadShader("simulation.comp")};
+	const std::string frameConstantsSource{LoadShader("frame_constants.glsl")};
+	CStdGLShaderProgram plainProgram;
+	LinkComputeProgram(plainProgram, simulationSource, frameConstantsSource, {{"SIMULATION_JACOBI", "1"}});
+
+	plainProgram.Select();
+	plainProgram.SetUniform("alpha", glUniform1f, Alpha);
+	plainProgram.SetUniform("beta", glUniform1f, Beta);
+	plainProgram.SetUniform("omega", glUniform1f, 1.0f);
+
+	GLuint query;
+	glGenQueries(1, &query);
+
+	// Average GPU time of one call of submit over the timed rounds
+	const auto measure = [&](const auto &submit)
+	{
+		glBeginQuery(GL_TIME_ELAPSED, query);
+		for (std::size_t i{0}; i < rounds; ++i)
+		{
+			submit();
+		}
+		glEndQuery(GL_TIME_ELAPSED);
+
+		GLuint64 elapsed{0};
+		glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+		return elapsed / 1000.0 / std::max<std::size_t>(rounds, 1);
+	};
+
+	const auto dispatch = [&]
+	{
+		glDispatchCompute(numGroupsX, numGroupsY, 1);
+		glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+	};
+
+	const auto runPlain = [&](const std::size_t sweeps)
+	{
+		plainProgram.Select();
+		for (std::size_t i{0}; i < sweeps; ++i)
+		{
+			CStdGLFluidSolver::BindTexture(plainProgram, "field", plain.GetFront().GetTexture());
+			CStdGLFluidSolver::BindTexture(plainProgram, "b", b.GetTexture());
+			plain.GetBack().GetTexture().BindImage(0, GL_READ_WRITE);
+			dispatch();
+			plain.SwapBuffers();
+		}
+	};
+
+	std::cout << std::left << std::setw(8) << "sweeps" << std::setw(16) << "max difference" << std::setw(12) << "tolerance" << std::setw(16) << "plain us/sweep" << std::setw(18) << "blocked us/sweep" << "result\n";
+
+	bool passed{true};
+	for (std::size_t sweeps{2}; sweeps <= 8; ++sweeps)
+	{
+		CStdGLShaderProgram blockedProgram;
+		LinkComputeProgram(blockedProgram, simulationSource, frameConstantsSource, {{"SIMULATION_JACOBI_BLOCKED", "1"}, {"BLOCK_SWEEPS", std::to_string(sweeps)}});
+
+		const auto runBlocked = [&]
+		{
+			blockedProgram.Select();
+			blockedProgram.SetUniform("alpha", glUniform1f, Alpha);
+			blockedProgram.SetUniform("beta", glUniform1f, Beta);
+			blockedProgram.SetUniform("sweeps", glUniform1i, static_cast<GLint>(sweeps));
+			CStdGLFluidSolver::BindTexture(blockedProgram, "x", x.GetTexture());
+			CStdGLFluidSolver::BindTexture(blockedProgram, "b", b.GetTexture());
+			blocked.GetTexture().BindImage(0, GL_WRITE_ONLY);
+			dispatch();
+		};
+
+		plain.GetFront().GetTexture().SetData(initialValue.data());
+		runPlain(sweeps);
+		runBlocked();
+
+		const std::vector<glm::vec2> expected{ReadField(plain.GetFront().GetTexture())};
+		const std::vector<glm::vec2> actual{ReadField(blocked.GetTexture())};
+
+		float difference{0.0f};
+		float magnitude{0.0f};
+		for (std::size_t i{0}; i < expected.size(); ++i)
+		{
+			const glm::vec2 error{glm::abs(expected[i] - actual[i])};
+			difference = std::max({difference, error.x, error.y});
+			magnitude = std::max({magnitude, std::abs(expected[i].x), std::abs(expected[i].y)});
+		}
+
+		// Every plain sweep rounds its result to fp16, the blocked kernel only the last one
+		const float tolerance{2.0f * sweeps * HalfEpsilon * magnitude};
+		const bool matches{difference <= tolerance};
+		passed = passed && matches;
+
+		const double plainTime{measure([&] { runPlain(sweeps); }) / sweeps};
+		const double blockedTime{measure(runBlocked) / sweeps};
+
+		std::cout << std::left << std::setw(8) << sweeps << std::setw(16) << std::scientific << std::setprecision(3) << difference
+			<< std::setw(12) << tolerance << std::fixed << std::setprecision(2) << std::setw(16) << plainTime << std::setw(18) << blockedTime
+			<< (matches ? "ok" : "FAILED") << "\n" << std::defaultfloat;
+	}
+
+	glDeleteQueries(1, &query);
+
+	return passed ? 0 : 1;
+}
\ No newline at end of file
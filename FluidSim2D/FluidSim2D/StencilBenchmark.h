@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstdint>
+
+// Times the stencil passes in every StencilFetch variant the driver supports and as tiled kernels of the compute backend, then prints the results.
+// Throughput and bandwidth come from GL_TIME_ELAPSED queries, the fetch counts are the ones the shaders are expected to issue.
+// Needs a current GL context. Options: --benchmark-stencils <draws per pass>
+int RunStencilBenchmark(int argc, char *argv[], std::int32_t width, std::int32_t height);
+
+// Compares SIMULATION_JACOBI_BLOCKED against as many plain SIMULATION_JACOBI dispatches for every block size from 2 to 8
+// and times both. Returns 1 if any block size differs by more than the fp16 rounding of the plain sweeps.
+// Needs a current GL context. Options: --check-jacobi-blocking <timed rounds>
+int RunJacobiBlockingCheck(int argc, char *argv[], std::int32_t width, std::int32_t height);
@@ -0,0 +1,107 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+namespace
+{
+	// Splits [begin, end) into count nearly equal chunks and returns the one at index
+	std::pair<std::int32_t, std::int32_t> Chunk(const std::int32_t begin, const std::int32_t end, const std::size_t index, const std::size_t count)
+	{
+		const std::int64_t size{end - begin};
+		const auto chunkBegin = begin + static_cast<std::int32_t>(size * static_cast<std::int64_t>(index) / static_cast<std::int64_t>(count));
+		const auto chunkEnd = begin + static_cast<std::int32_t>(size * static_cast<std::int64_t>(index + 1) / static_cast<std::int64_t>(count));
+		return {chunkBegin, chunkEnd};
+	}
+}
+
+CStdThreadPool::CStdThreadPool(const std::size_t numThreads)
+{
+	// The calling thread takes the first chunk itself
+	const std::size_t numWorkers{std::max<std::size_t>(numThreads, 1) - 1};
+	workers.reserve(numWorkers);
+
+	for (std::size_t i{0}; i < numWorkers; ++i)
+	{
+		workers.emplace_back(&CStdThreadPool::WorkerLoop, this, i + 1);
+	}
+}
+
+CStdThreadPool::~CStdThreadPool()
+{
+	{
+		std::lock_guard lock{mutex};
+		stop = true;
+	}
+	wakeCondition.notify_all();
+
+	for (auto &worker : workers)
+	{
+		worker.join();
+	}
+}
+
+void CStdThreadPool::ParallelFor(const std::int32_t begin, const std::int32_t end, const RangeFunction &function)
+{
+	if (workers.empty() || end - begin < static_cast<std::int32_t>(GetNumThreads()))
+	{
+		function(begin, end);
+		return;
+	}
+
+	{
+		std::lock_guard lock{mutex};
+		currentFunction = &function;
+		currentBegin = begin;
+		currentEnd = end;
+		pendingWorkers = workers.size();
+		++generation;
+	}
+	wakeCondition.notify_all();
+
+	const auto [chunkBegin, chunkEnd] = Chunk(begin, end, 0, GetNumThreads());
+	function(chunkBegin, chunkEnd);
+
+	std::unique_lock lock{mutex};
+	doneCondition.wait(lock, [this] { return pendingWorkers == 0; });
+	currentFunction = nullptr;
+}
+
+void CStdThreadPool::WorkerLoop(const std::size_t index)
+{
+	std::uint64_t lastGeneration{0};
+
+	for (;;)
+	{
+		const RangeFunction *function;
+		std::int32_t begin;
+		std::int32_t end;
+
+		{
+			std::unique_lock lock{mutex};
+			wakeCondition.wait(lock, [this, lastGeneration] { return stop || generation != lastGeneration; });
+			if (stop)
+			{
+				return;
+			}
+
+			lastGeneration = generation;
+			function = currentFunction;
+			begin = currentBegin;
+			end = currentEnd;
+		}
+
+		const auto [chunkBegin, chunkEnd] = Chunk(begin, end, index, GetNumThreads());
+		(*function)(chunkBegin, chunkEnd);
+
+		bool last;
+		{
+			std::lock_guard lock{mutex};
+			last = --pendingWorkers == 0;
+		}
+
+		if (last)
+		{
+			doneCondition.notify_one();
+		}
+	}
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+// Persistent worker threads that split row ranges of a grid between them.
+// ParallelFor blocks until every worker has finished its share.
+class CStdThreadPool
+{
+public:
+	using RangeFunction = std::function<void(std::int32_t begin, std::int32_t end)>;
+
+public:
+	explicit CStdThreadPool(std::size_t numThreads = std::thread::hardware_concurrency());
+	CStdThreadPool(const CStdThreadPool &) = delete;
+	~CStdThreadPool();
+
+public:
+	void ParallelFor(std::int32_t begin, std::int32_t end, const RangeFunction &function);
+
+	// Calls function(x, y) for every cell of a width x height grid, rows are split between the threads
+	template<typename Func> void ForEachCell(std::int32_t width, std::int32_t height, Func &&function)
+	{
+		ParallelFor(0, height, [width, &function](const std::int32_t begin, const std::int32_t end)
+		{
+			for (std::int32_t y{begin}; y < end; ++y)
+			{
+				for (std::int32_t x{0}; x < width; ++x)
+				{
+					function(x, y);
+				}
+			}
+		});
+	}
+
+	// Sums function(y) over the rows [begin, end). Row results are added up in order afterwards,
+	// so the result does not depend on the number of threads.
+	template<typename Result, typename Func> Result ParallelReduce(std::int32_t begin, std::int32_t end, Func &&function)
+	{
+		std::vector<Result> rows(static_cast<std::size_t>(std::max(end - begin, 0)), Result{});
+
+		ParallelFor(begin, end, [begin, &rows, &function](const std::int32_t rangeBegin, const std::int32_t rangeEnd)
+		{
+			for (std::int32_t y{rangeBegin}; y < rangeEnd; ++y)
+			{
+				rows[y - begin] = function(y);
+			}
+		});
+
+		return std::accumulate(rows.begin(), rows.end(), Result{});
+	}
+
+	std::size_t GetNumThreads() const { return workers.size() + 1; }
+
+private:
+	void WorkerLoop(std::size_t index);
+
+private:
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable wakeCondition;
+	std::condition_variable doneCondition;
+
+	const RangeFunction *currentFunction{nullptr};
+	std::int32_t currentBegin{0};
+	std::int32_t currentEnd{0};
+	std::uint64_t generation{0};
+	std::size_t pendingWorkers{0};
+	bool stop{false};
+};
@@ -4,9 +4,7 @@ precision highp float;
 
 uniform vec2 position;		// Cursor position
 uniform vec3 force;			// The force
-uniform float radius;		// Radius of gaussian splat
-uniform float delta_t;		// Time step
-uniform sampler2D velocity;	// Velocity field
+layout(binding = 0) uniform sampler2D velocity;	// Velocity field
 
 varying vec2 coord;
 out vec4 FragColor;
@@ -14,7 +12,7 @@ out vec4 FragColor;
 void main()
 {
 	vec2 diff = position - coord;
-	float x = -dot(diff,diff) / radius;
+	float x = -dot(diff,diff) / splatRadius;
 	vec3 effect = force * exp(x);
 	vec3 u0 = texture2D(velocity, coord).xyz;
 
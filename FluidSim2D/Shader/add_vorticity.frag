@@ -2,11 +2,8 @@
 
 #define EPSILON 0.00024414
 
-uniform sampler2D velocity;
-uniform sampler2D vorticity;
-uniform float scale;
-uniform float delta_t;
-uniform float gs;
+layout(binding = 0) uniform sampler2D velocity;
+layout(binding = 1) uniform sampler2D vorticity;
 
 varying vec2 coord;
 varying vec2 pxT;
@@ -27,10 +24,11 @@ void main()
     vec2 force = vec2(abs(T) - abs(B), abs(R) - abs(L)) / (2 * gs);
     float mag_sq = max(EPSILON, dot(force,force));
     force *= inversesqrt(mag_sq);
-    force *= scale * C * vec2(1,-1);
+    force *= vorticityScale * C * vec2(1,-1);
 
     vec2 v = texture2D(velocity, coord).xy;
-    v += delta_t * force;
+    // Applied once per step, independent of delta_t
+    v += force;
 
     FragColor = vec4(v, 0.0, 1.0);
 }
\ No newline at end of file
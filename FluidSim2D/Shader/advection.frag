@@ -2,11 +2,8 @@
 
 precision highp float;
 
-uniform float delta_t;                      // Time step
-uniform float dissipation = 1.0f;           // Dissipation factor
-uniform sampler2D velocity;                 // The velocity field doing the advecting
-uniform sampler2D quantity;                 // The quantity to advect
-uniform float gs;                           // 1 / Grid scale 
+layout(binding = 0) uniform sampler2D velocity;                 // The velocity field doing the advecting
+layout(binding = 1) uniform sampler2D quantity;                 // The quantity to advect
 
 varying vec2 coord;
 
@@ -1,17 +1,18 @@
 #version 330 core
 
-uniform sampler2D field;
-uniform vec2 rdv;
-uniform vec2 offset;
-uniform float scale;
+#include "boundary.glsl"
 
-varying vec2 coord;
+layout(binding = 0) uniform sampler2D field;
+uniform ivec4 conditions;
+uniform vec2 inflow;
 
 out vec4 FragColor;
 
+// Drawn as lines over the rim into field itself, which is fine since only interior cells are read
 void main()
 {
-	vec2 value = texture2D(field, coord + (offset * rdv)).xy;
-	value = scale * value;
-	FragColor = vec4(value, 0.0, 1.0);
+	ivec2 size = textureSize(field, 0);
+	ivec2 cell = ivec2(gl_FragCoord.xy);
+	vec2 value = texelFetch(field, BoundarySource(cell, size, conditions), 0).xy;
+	FragColor = vec4(BoundaryValue(cell, size, conditions, inflow, value), 0.0, 1.0);
 }
\ No newline at end of file
@@ -0,0 +1,65 @@
+// Ghost cell rules of the velocity rim, included by boundary.frag and simulation.comp.
+// conditions holds the BoundaryCondition of the left, right, bottom and top side.
+// Every rim cell takes its value from an interior cell, so the rim can be updated in place.
+#define BOUNDARY_NO_SLIP 0
+#define BOUNDARY_FREE_SLIP 1
+#define BOUNDARY_INFLOW 2
+#define BOUNDARY_OUTFLOW 3
+#define BOUNDARY_PERIODIC 4
+
+// The inward neighbour, or the interior cell next to the opposite side for periodic sides. Corners take the diagonal one.
+ivec2 BoundarySource(ivec2 cell, ivec2 size, ivec4 conditions)
+{
+	ivec2 source = cell;
+
+	if (cell.x == 0)
+	{
+		source.x = conditions.x == BOUNDARY_PERIODIC ? size.x - 2 : 1;
+	}
+	else if (cell.x == size.x - 1)
+	{
+		source.x = conditions.y == BOUNDARY_PERIODIC ? 1 : size.x - 2;
+	}
+
+	if (cell.y == 0)
+	{
+		source.y = conditions.z == BOUNDARY_PERIODIC ? size.y - 2 : 1;
+	}
+	else if (cell.y == size.y - 1)
+	{
+		source.y = conditions.w == BOUNDARY_PERIODIC ? 1 : size.y - 2;
+	}
+
+	return source;
+}
+
+// Rim value for the value of its source cell. The left and right side decide the corners unless they are periodic.
+vec2 BoundaryValue(ivec2 cell, ivec2 size, ivec4 conditions, vec2 inflow, vec2 value)
+{
+	int condition = BOUNDARY_PERIODIC;
+	vec2 normal = vec2(0.0);
+
+	if (cell.x == 0 || cell.x == size.x - 1)
+	{
+		condition = cell.x == 0 ? conditions.x : conditions.y;
+		normal = vec2(1.0, 0.0);
+	}
+
+	if (condition == BOUNDARY_PERIODIC && (cell.y == 0 || cell.y == size.y - 1))
+	{
+		condition = cell.y == 0 ? conditions.z : conditions.w;
+		normal = vec2(0.0, 1.0);
+	}
+
+	switch (condition)
+	{
+	case BOUNDARY_NO_SLIP:
+		return -value;
+	case BOUNDARY_FREE_SLIP:
+		return value - 2.0 * normal * dot(value, normal);
+	case BOUNDARY_INFLOW:
+		return inflow;
+	default:
+		return value;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,56 @@
+#version 330 core
+
+precision highp float;
+
+// Chebyshev accelerated Jacobi sweep, see CStdChebyshevWeights:
+// result = previous + omega * (jacobi(x) - previous)
+// previous is the texture that is rendered into. Every fragment reads and writes only its own texel,
+// which is well defined once a texture barrier made the earlier writes visible.
+
+uniform float beta;
+uniform float alpha;
+uniform float omega;
+layout(binding = 0) uniform sampler2D x;
+layout(binding = 1) uniform sampler2D b;
+layout(binding = 2) uniform sampler2D previous;
+// Pressure only, the Neumann faces of jacobi.frag. OBSTACLES is the axis of the variants, see CStdShaderVariants.
+#if defined(OBSTACLES)
+const bool obstacles = OBSTACLES != 0;
+#else
+uniform bool obstacles;
+#endif
+layout(binding = 3) uniform sampler2D obstacleField;
+
+varying vec2 coord;
+varying vec2 pxT;
+varying vec2 pxB;
+varying vec2 pxL;
+varying vec2 pxR;
+
+out vec4 FragColor;
+
+void main()
+{
+    vec3 xL = texture2D(x, pxL).xyz;
+    vec3 xR = texture2D(x, pxR).xyz;
+    vec3 xB = texture2D(x, pxB).xyz;
+    vec3 xT = texture2D(x, pxT).xyz;
+    vec3 bC = texture2D(b, coord).xyz;
+    vec3 xPrevious = texture2D(previous, coord).xyz;
+
+    vec3 jacobi = (xL + xR + xB + xT + (alpha * bC)) / beta;
+    bool solid = false;
+
+    if (obstacles)
+    {
+        ivec2 obstacleCell = ivec2(gl_FragCoord.xy);
+        int mask = int(texelFetch(obstacleField, obstacleCell, 0).x);
+        int solidNeighbours = (mask & 1) + ((mask >> 1) & 1) + ((mask >> 2) & 1) + ((mask >> 3) & 1);
+        jacobi += float(solidNeighbours) * texelFetch(x, obstacleCell, 0).xyz / beta;
+        solid = mask >= 16;
+    }
+
+    vec3 result = solid ? vec3(0.0) : xPrevious + omega * (jacobi - xPrevious);
+
+    FragColor = vec4(result, 1.0);
+}
\ No newline at end of file
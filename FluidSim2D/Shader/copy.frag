@@ -2,7 +2,7 @@
 
 precision highp float;
 
-uniform sampler2D field;
+layout(binding = 0) uniform sampler2D field;
 
 varying vec2 coord;
 
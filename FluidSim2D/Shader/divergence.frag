@@ -2,8 +2,10 @@
 
 precision highp float;
 
-uniform sampler2D field;
-uniform float gs;
+// STENCIL_TEXEL_FETCH and STENCIL_GATHER select the integer coordinate variants, see CStdGLFluidSolver::SetStencilFetch,
+// which also enables GL_ARB_gpu_shader5 for the gather variant
+
+layout(binding = 0) uniform sampler2D field;
 
 varying vec2 coord;
 varying vec2 pxT;
@@ -15,10 +17,35 @@ out vec4 FragColor;
 
 void main()
 {
+#if defined(STENCIL_GATHER)
+    // The gathers around the lower left and upper right corner of the cell return (L, C, B, -) and (T, -, R, C)
+    vec2 size = vec2(textureSize(field, 0));
+    vec2 lower = floor(gl_FragCoord.xy) / size;
+    vec2 upper = (floor(gl_FragCoord.xy) + 1.0) / size;
+
+    vec4 lowerX = textureGather(field, lower, 0);
+    vec4 upperX = textureGather(field, upper, 0);
+    vec4 lowerY = textureGather(field, lower, 1);
+    vec4 upperY = textureGather(field, upper, 1);
+
+    vec2 R = vec2(upperX.z, upperY.z);
+    vec2 L = vec2(lowerX.x, lowerY.x);
+    vec2 B = vec2(lowerX.z, lowerY.z);
+    vec2 T = vec2(upperX.x, upperY.x);
+#elif defined(STENCIL_TEXEL_FETCH)
+    ivec2 size = textureSize(field, 0);
+    ivec2 cell = ivec2(gl_FragCoord.xy);
+
+    vec2 R = texelFetch(field, (cell + ivec2(1, 0)) % size, 0).xy;
+    vec2 L = texelFetch(field, (cell + ivec2(-1, 0) + size) % size, 0).xy;
+    vec2 B = texelFetch(field, (cell + ivec2(0, -1) + size) % size, 0).xy;
+    vec2 T = texelFetch(field, (cell + ivec2(0, 1)) % size, 0).xy;
+#else
     vec2 R = texture2D(field, pxR).xy;
     vec2 L = texture2D(field, pxL).xy;
     vec2 B = texture2D(field, pxB).xy;
     vec2 T = texture2D(field, pxT).xy;
+#endif
     
     float div = (R.x - L.x)/(2 * gs) + (T.y - B.y)/(2 * gs);
 
@@ -0,0 +1,39 @@
+#version 430 core
+
+precision highp float;
+
+// divergence.frag folded into the first Jacobi sweep of the pressure solve.
+// div(W) is the right hand side of the remaining sweeps, it is stored on the side through the image.
+// The image has no format qualifier, it takes the velocity format of the bound texture like the write only images of simulation.comp.
+
+layout(binding = 1) uniform sampler2D velocity;
+layout(binding = 0) uniform sampler2D x;
+uniform float alpha;
+uniform float beta;
+
+layout(binding = 0) writeonly uniform image2D divergence;
+
+out vec4 FragColor;
+
+void main()
+{
+    ivec2 size = textureSize(x, 0);
+    ivec2 cell = ivec2(gl_FragCoord.xy);
+
+    vec2 R = texelFetch(velocity, (cell + ivec2(1, 0)) % size, 0).xy;
+    vec2 L = texelFetch(velocity, (cell + ivec2(-1, 0) + size) % size, 0).xy;
+    vec2 B = texelFetch(velocity, (cell + ivec2(0, -1) + size) % size, 0).xy;
+    vec2 T = texelFetch(velocity, (cell + ivec2(0, 1)) % size, 0).xy;
+
+    float div = (R.x - L.x)/(2 * gs) + (T.y - B.y)/(2 * gs);
+    imageStore(divergence, cell, vec4(div, 0.0, 0.0, 1.0));
+
+    vec2 xL = texelFetch(x, (cell + ivec2(-1, 0) + size) % size, 0).xy;
+    vec2 xR = texelFetch(x, (cell + ivec2(1, 0)) % size, 0).xy;
+    vec2 xB = texelFetch(x, (cell + ivec2(0, -1) + size) % size, 0).xy;
+    vec2 xT = texelFetch(x, (cell + ivec2(0, 1)) % size, 0).xy;
+
+    vec2 result = (xL + xR + xB + xT + alpha * vec2(div, 0.0)) / beta;
+
+    FragColor = vec4(result, 0.0, 1.0);
+}
\ No newline at end of file
@@ -14,7 +14,10 @@ void main()
 };
 */
 
-uniform sampler2D field;
+layout(binding = 0) uniform sampler2D field;
+// Signed distance of obstacles.comp in y, the solid cells are drawn grey with an antialiased edge
+uniform bool obstacles;
+layout(binding = 1) uniform sampler2D obstacleField;
 
 in vec2 vTex;
 
@@ -23,4 +26,10 @@ out vec4 FragColor;
 void main()
 {
 	FragColor = vec4(vec2(0.5, 0.5) + vec2(0.5, 0.5) * texture(field, vTex).rg, 0.5, 1.0);
+
+	if (obstacles)
+	{
+		float distance = texture(obstacleField, vTex).y;
+		FragColor.rgb = mix(vec3(0.2), FragColor.rgb, smoothstep(-0.5, 0.5, distance));
+	}
 }
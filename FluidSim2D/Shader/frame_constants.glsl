@@ -0,0 +1,10 @@
+// Per-frame constants, CStdGLFluidSolver::FrameConstants fills the block once per Step
+layout(std140) uniform FrameConstants
+{
+	vec2 texelSize;			// 1 / grid size
+	float gs;				// Grid scale
+	float delta_t;			// Time step
+	float dissipation;		// Dissipation factor of the advection
+	float splatRadius;		// Radius of the gaussian impulse splat
+	float vorticityScale;	// Strength of the vorticity confinement
+};
\ No newline at end of file
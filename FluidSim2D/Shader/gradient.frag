@@ -2,8 +2,10 @@
 
 precision highp float;
 
-uniform sampler2D field;
-uniform float gs;
+// STENCIL_TEXEL_FETCH and STENCIL_GATHER select the integer coordinate variants, see CStdGLFluidSolver::SetStencilFetch,
+// which also enables GL_ARB_gpu_shader5 for the gather variant
+
+layout(binding = 0) uniform sampler2D field;
 
 varying vec2 coord;
 varying vec2 pxT;
@@ -15,10 +17,30 @@ out vec4 FragColor;
 
 void main()
 {
+#if defined(STENCIL_GATHER)
+    // The gathers around the lower left and upper right corner of the cell return (L, C, B, -) and (T, -, R, C)
+    vec2 size = vec2(textureSize(field, 0));
+    vec4 lower = textureGather(field, floor(gl_FragCoord.xy) / size, 0);
+    vec4 upper = textureGather(field, (floor(gl_FragCoord.xy) + 1.0) / size, 0);
+
+    float R = upper.z;
+    float L = lower.x;
+    float B = lower.z;
+    float T = upper.x;
+#elif defined(STENCIL_TEXEL_FETCH)
+    ivec2 size = textureSize(field, 0);
+    ivec2 cell = ivec2(gl_FragCoord.xy);
+
+    float R = texelFetch(field, (cell + ivec2(1, 0)) % size, 0).x;
+    float L = texelFetch(field, (cell + ivec2(-1, 0) + size) % size, 0).x;
+    float B = texelFetch(field, (cell + ivec2(0, -1) + size) % size, 0).x;
+    float T = texelFetch(field, (cell + ivec2(0, 1)) % size, 0).x;
+#else
     float R = texture2D(field, pxR).x;
     float L = texture2D(field, pxL).x;
     float B = texture2D(field, pxB).x;
     float T = texture2D(field, pxT).x;
+#endif
     
     vec2 gradient = vec2(R-L, T-B)/(2 * gs);
     FragColor = vec4(gradient, 0.0, 1.0);
@@ -0,0 +1,26 @@
+#version 330 core
+
+precision highp float;
+
+// gradient.frag and subtract.frag in one pass: U = W - grad(P)
+
+layout(binding = 0) uniform sampler2D field;
+layout(binding = 1) uniform sampler2D velocity;
+
+out vec4 FragColor;
+
+void main()
+{
+    ivec2 size = textureSize(field, 0);
+    ivec2 cell = ivec2(gl_FragCoord.xy);
+
+    float R = texelFetch(field, (cell + ivec2(1, 0)) % size, 0).x;
+    float L = texelFetch(field, (cell + ivec2(-1, 0) + size) % size, 0).x;
+    float B = texelFetch(field, (cell + ivec2(0, -1) + size) % size, 0).x;
+    float T = texelFetch(field, (cell + ivec2(0, 1)) % size, 0).x;
+
+    vec2 gradient = vec2(R-L, T-B)/(2 * gs);
+    vec2 v = texelFetch(velocity, cell, 0).xy - gradient;
+
+    FragColor = vec4(v, 0.0, 1.0);
+}
\ No newline at end of file
@@ -2,10 +2,34 @@
 
 precision highp float;
 
+// STENCIL_TEXEL_FETCH and STENCIL_GATHER select the integer coordinate variants, see CStdGLFluidSolver::SetStencilFetch,
+// which also enables GL_ARB_gpu_shader5 for the gather variant
+
 uniform float beta;
 uniform float alpha;
-uniform sampler2D x;
-uniform sampler2D b;
+layout(binding = 0) uniform sampler2D x;
+layout(binding = 1) uniform sampler2D b;
+// OBSTACLES, SCALAR and GRID_WIDTH/GRID_HEIGHT are the axes of the variants, see CStdShaderVariants. A variant has constants instead of the uniforms.
+// Only the first channel is solved, the gather variant skips the second one
+#if defined(SCALAR)
+const bool scalar = SCALAR != 0;
+#else
+uniform bool scalar;
+#endif
+// Pressure only: obstacleField holds the bit mask of obstacles.glsl in x. Solid cells are kept at 0,
+// a solid neighbour counts with the centre value instead, which makes its face a Neumann boundary.
+#if defined(OBSTACLES)
+const bool obstacles = OBSTACLES != 0;
+#else
+uniform bool obstacles;
+#endif
+layout(binding = 3) uniform sampler2D obstacleField;
+
+#if defined(GRID_WIDTH)
+#define GRID_SIZE ivec2(GRID_WIDTH, GRID_HEIGHT)
+#else
+#define GRID_SIZE textureSize(x, 0)
+#endif
 
 varying vec2 coord;
 varying vec2 pxT;
@@ -17,6 +41,38 @@ out vec4 FragColor;
 
 void main()
 {
+#if defined(STENCIL_GATHER)
+    // The gathers around the lower left and upper right corner of the cell return (L, C, B, -) and (T, -, R, C)
+    vec2 size = vec2(GRID_SIZE);
+    vec2 lower = floor(gl_FragCoord.xy) / size;
+    vec2 upper = (floor(gl_FragCoord.xy) + 1.0) / size;
+
+    vec4 lowerX = textureGather(x, lower, 0);
+    vec4 upperX = textureGather(x, upper, 0);
+    vec3 neighbours = vec3(lowerX.x + lowerX.z + upperX.x + upperX.z, 0.0, 0.0);
+
+    if (!scalar)
+    {
+        vec4 lowerY = textureGather(x, lower, 1);
+        vec4 upperY = textureGather(x, upper, 1);
+        neighbours.y = lowerY.x + lowerY.z + upperY.x + upperY.z;
+    }
+
+    vec3 bC = texelFetch(b, ivec2(gl_FragCoord.xy), 0).xyz;
+
+    vec3 result = (neighbours + (alpha * bC)) / beta;
+#elif defined(STENCIL_TEXEL_FETCH)
+    ivec2 size = GRID_SIZE;
+    ivec2 cell = ivec2(gl_FragCoord.xy);
+
+    vec3 xL = texelFetch(x, (cell + ivec2(-1, 0) + size) % size, 0).xyz;
+    vec3 xR = texelFetch(x, (cell + ivec2(1, 0)) % size, 0).xyz;
+    vec3 xB = texelFetch(x, (cell + ivec2(0, -1) + size) % size, 0).xyz;
+    vec3 xT = texelFetch(x, (cell + ivec2(0, 1)) % size, 0).xyz;
+    vec3 bC = texelFetch(b, cell, 0).xyz;
+
+    vec3 result = (xL + xR + xB + xT + (alpha * bC)) / beta;
+#else
     vec3 xL = texture2D(x, pxL).xyz;
     vec3 xR = texture2D(x, pxR).xyz;
     vec3 xB = texture2D(x, pxB).xyz;
@@ -24,6 +80,15 @@ void main()
     vec3 bC = texture2D(b, coord).xyz;
 
     vec3 result = (xL + xR + xB + xT + (alpha * bC)) / beta;
+#endif
+
+    if (obstacles)
+    {
+        ivec2 obstacleCell = ivec2(gl_FragCoord.xy);
+        int mask = int(texelFetch(obstacleField, obstacleCell, 0).x);
+        int solidNeighbours = (mask & 1) + ((mask >> 1) & 1) + ((mask >> 2) & 1) + ((mask >> 3) & 1);
+        result = mask >= 16 ? vec3(0.0) : result + float(solidNeighbours) * texelFetch(x, obstacleCell, 0).xyz / beta;
+    }
 
     FragColor = vec4(result, 1.0);
 }
\ No newline at end of file
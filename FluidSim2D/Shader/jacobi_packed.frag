@@ -0,0 +1,51 @@
+#version 330 core
+
+precision highp float;
+
+// jacobi.frag on the pack.frag layout, one fragment updates a 2x2 block of cells.
+// Every cell has two of its neighbours in its own texel and the other two in the texels next to it,
+// so five fetches of x and one of b cover all four cells. Neighbours wrap around like GL_REPEAT,
+// which is exact because the packed grid only exists for even sizes.
+// With omega != 1 the sweep is weighted against x(k - 1) like chebyshev.frag.
+
+uniform float beta;
+uniform float alpha;
+uniform float omega;
+layout(binding = 0) uniform sampler2D x;
+layout(binding = 1) uniform sampler2D b;
+layout(binding = 2) uniform sampler2D previous;
+
+out vec4 FragColor;
+
+vec4 Fetch(ivec2 texel, ivec2 size)
+{
+    return texelFetch(x, (texel + size) % size, 0);
+}
+
+void main()
+{
+    ivec2 size = textureSize(x, 0);
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+
+    vec4 C = Fetch(texel, size);
+    vec4 L = Fetch(texel + ivec2(-1, 0), size);
+    vec4 R = Fetch(texel + ivec2(1, 0), size);
+    vec4 B = Fetch(texel + ivec2(0, -1), size);
+    vec4 T = Fetch(texel + ivec2(0, 1), size);
+    vec4 bC = texelFetch(b, texel, 0);
+
+    vec4 neighbours = vec4(L.g + C.g + B.b + C.b,
+        C.r + R.r + B.a + C.a,
+        L.a + C.a + C.r + T.r,
+        C.b + R.b + C.g + T.g);
+
+    vec4 result = (neighbours + alpha * bC) / beta;
+
+    if (omega != 1.0)
+    {
+        vec4 xPrevious = texelFetch(previous, texel, 0);
+        result = xPrevious + omega * (result - xPrevious);
+    }
+
+    FragColor = result;
+}
\ No newline at end of file
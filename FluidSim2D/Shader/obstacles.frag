@@ -0,0 +1,16 @@
+#version 330 core
+
+#include "obstacles.glsl"
+
+layout(binding = 0) uniform sampler2D field;
+layout(binding = 1) uniform sampler2D obstacleField;
+
+out vec4 FragColor;
+
+// Drawn into field itself, every fragment only reads its own texel
+void main()
+{
+	ivec2 cell = ivec2(gl_FragCoord.xy);
+	int mask = int(texelFetch(obstacleField, cell, 0).x);
+	FragColor = vec4(ObstacleVelocity(mask, texelFetch(field, cell, 0).xy), 0.0, 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,23 @@
+// Obstacle field of CStdGLFluidSolver, included by obstacles.frag, obstacles.comp and simulation.comp.
+// x holds a bit mask of the solid neighbours, plus OBSTACLE_SOLID for solid cells, y the signed distance to the nearest face in cells.
+#define OBSTACLE_LEFT 1
+#define OBSTACLE_RIGHT 2
+#define OBSTACLE_BOTTOM 4
+#define OBSTACLE_TOP 8
+#define OBSTACLE_SOLID 16
+
+int SolidNeighbours(int mask)
+{
+	return (mask & 1) + ((mask >> 1) & 1) + ((mask >> 2) & 1) + ((mask >> 3) & 1);
+}
+
+// Solid cells do not move, fluid cells lose the velocity component towards a solid neighbour
+vec2 ObstacleVelocity(int mask, vec2 velocity)
+{
+	if (mask >= OBSTACLE_SOLID)
+	{
+		return vec2(0.0);
+	}
+
+	return vec2((mask & (OBSTACLE_LEFT | OBSTACLE_RIGHT)) != 0 ? 0.0 : velocity.x, (mask & (OBSTACLE_BOTTOM | OBSTACLE_TOP)) != 0 ? 0.0 : velocity.y);
+}
\ No newline at end of file
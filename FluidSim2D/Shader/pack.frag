@@ -0,0 +1,21 @@
+#version 330 core
+
+precision highp float;
+
+// Packs the first channel of a 2x2 block of cells into one texel of the half size target:
+// r = (2i, 2j), g = (2i + 1, 2j), b = (2i, 2j + 1), a = (2i + 1, 2j + 1).
+// The red cells of the red-black ordering end up in r and a, the black ones in g and b.
+
+layout(binding = 0) uniform sampler2D field;
+
+out vec4 FragColor;
+
+void main()
+{
+    ivec2 cell = 2 * ivec2(gl_FragCoord.xy);
+
+    FragColor = vec4(texelFetch(field, cell, 0).x,
+        texelFetch(field, cell + ivec2(1, 0), 0).x,
+        texelFetch(field, cell + ivec2(0, 1), 0).x,
+        texelFetch(field, cell + ivec2(1, 1), 0).x);
+}
\ No newline at end of file
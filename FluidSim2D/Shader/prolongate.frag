@@ -0,0 +1,18 @@
+#version 330 core
+
+precision highp float;
+
+layout(binding = 0) uniform sampler2D field;
+layout(binding = 1) uniform sampler2D correction;	// Coarse grid correction, bilinearly interpolated
+
+varying vec2 coord;
+
+out vec4 FragColor;
+
+void main()
+{
+    vec2 value = texture2D(field, coord).xy;
+    vec2 delta = texture2D(correction, coord).xy;
+
+    FragColor = vec4(value + delta, 0.0, 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,40 @@
+#version 330 core
+
+precision highp float;
+
+uniform float beta;
+uniform float alpha;
+layout(binding = 0) uniform sampler2D x;
+layout(binding = 1) uniform sampler2D b;
+// Pressure only, the Neumann faces of jacobi.frag
+uniform bool obstacles;
+layout(binding = 2) uniform sampler2D obstacleField;
+
+varying vec2 coord;
+varying vec2 pxT;
+varying vec2 pxB;
+varying vec2 pxL;
+varying vec2 pxR;
+
+out vec4 FragColor;
+
+void main()
+{
+    vec3 xL = texture2D(x, pxL).xyz;
+    vec3 xR = texture2D(x, pxR).xyz;
+    vec3 xB = texture2D(x, pxB).xyz;
+    vec3 xT = texture2D(x, pxT).xyz;
+    vec3 xC = texture2D(x, coord).xyz;
+    vec3 bC = texture2D(b, coord).xyz;
+
+    vec3 residual = (alpha * bC) - (beta * xC - (xL + xR + xB + xT));
+
+    if (obstacles)
+    {
+        int mask = int(texelFetch(obstacleField, ivec2(gl_FragCoord.xy), 0).x);
+        int solidNeighbours = (mask & 1) + ((mask >> 1) & 1) + ((mask >> 2) & 1) + ((mask >> 3) & 1);
+        residual = mask >= 16 ? vec3(0.0) : residual + float(solidNeighbours) * xC;
+    }
+
+    FragColor = vec4(residual, 1.0);
+}
\ No newline at end of file
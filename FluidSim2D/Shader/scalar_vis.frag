@@ -1,6 +1,6 @@
 #version 330 core
 
-uniform sampler2D field;
+layout(binding = 0) uniform sampler2D field;
 uniform vec4 bias;
 uniform vec4 scale;
 
@@ -0,0 +1,31 @@
+#version 330 core
+
+precision highp float;
+
+uniform float beta;
+uniform float alpha;
+uniform float omega;		// Damping weight of the Jacobi update
+layout(binding = 0) uniform sampler2D x;
+layout(binding = 1) uniform sampler2D b;
+
+varying vec2 coord;
+varying vec2 pxT;
+varying vec2 pxB;
+varying vec2 pxL;
+varying vec2 pxR;
+
+out vec4 FragColor;
+
+void main()
+{
+    vec3 xL = texture2D(x, pxL).xyz;
+    vec3 xR = texture2D(x, pxR).xyz;
+    vec3 xB = texture2D(x, pxB).xyz;
+    vec3 xT = texture2D(x, pxT).xyz;
+    vec3 xC = texture2D(x, coord).xyz;
+    vec3 bC = texture2D(b, coord).xyz;
+
+    vec3 jacobi = (xL + xR + xB + xT + (alpha * bC)) / beta;
+
+    FragColor = vec4(mix(xC, jacobi, omega), 1.0);
+}
\ No newline at end of file
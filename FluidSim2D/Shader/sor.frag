@@ -0,0 +1,34 @@
+#version 330 core
+
+precision highp float;
+
+uniform float beta;
+uniform float alpha;
+uniform float omega;		// Over-relaxation factor, 1 is plain Gauss-Seidel
+uniform int parity;			// 0 updates red cells, 1 updates black cells
+layout(binding = 0) uniform sampler2D x;		// Also the render target, only the other color is read on even grid sizes
+layout(binding = 1) uniform sampler2D b;
+
+out vec4 FragColor;
+
+// Always texelFetch: the in-place update needs the exact texels of the neighbours, which filtered reads of the render target do not guarantee
+void main()
+{
+    ivec2 size = textureSize(x, 0);
+    ivec2 cell = ivec2(gl_FragCoord.xy);
+    if (((cell.x + cell.y) & 1) != parity)
+    {
+        discard;
+    }
+
+    vec3 xL = texelFetch(x, (cell + ivec2(-1, 0) + size) % size, 0).xyz;
+    vec3 xR = texelFetch(x, (cell + ivec2(1, 0)) % size, 0).xyz;
+    vec3 xB = texelFetch(x, (cell + ivec2(0, -1) + size) % size, 0).xyz;
+    vec3 xT = texelFetch(x, (cell + ivec2(0, 1)) % size, 0).xyz;
+    vec3 xC = texelFetch(x, cell, 0).xyz;
+    vec3 bC = texelFetch(b, cell, 0).xyz;
+
+    vec3 gaussSeidel = (xL + xR + xB + xT + (alpha * bC)) / beta;
+
+    FragColor = vec4(mix(xC, gaussSeidel, omega), 1.0);
+}
\ No newline at end of file
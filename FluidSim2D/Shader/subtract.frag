@@ -2,8 +2,8 @@
 
 precision highp float;
 
-uniform sampler2D a;
-uniform sampler2D b;
+layout(binding = 0) uniform sampler2D a;
+layout(binding = 1) uniform sampler2D b;
 
 varying vec2 coord;
 
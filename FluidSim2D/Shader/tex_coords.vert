@@ -5,7 +5,8 @@ precision highp float;
 layout (location=0)
 in vec3 vertex;
 
-uniform vec2 stride;
+// Texel size of the render target, 0 takes the one of the simulation grid. Only the multigrid levels set it.
+uniform vec2 stride = vec2(0.0);
 
 varying vec2 coord;
 varying vec2 pxL;
@@ -22,9 +23,11 @@ void main()
 {
     gl_Position = vec4(vertex.xy, 0.0, 1.0);
 
+    vec2 texel = stride.x > 0.0 ? stride : texelSize;
+
     coord = centerhalf(vertex.xy);
-    pxL = coord - vec2(stride.x, 0);
-    pxR = coord + vec2(stride.x, 0);
-    pxB = coord - vec2(0, stride.y);
-    pxT = coord + vec2(0, stride.y);
+    pxL = coord - vec2(texel.x, 0);
+    pxR = coord + vec2(texel.x, 0);
+    pxB = coord - vec2(0, texel.y);
+    pxT = coord + vec2(0, texel.y);
 }
\ No newline at end of file
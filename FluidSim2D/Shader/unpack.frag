@@ -0,0 +1,19 @@
+#version 330 core
+
+precision highp float;
+
+// Inverse of pack.frag, writes the cell into the first channel of the full size target
+
+layout(binding = 0) uniform sampler2D packed;
+
+out vec4 FragColor;
+
+void main()
+{
+    ivec2 cell = ivec2(gl_FragCoord.xy);
+    vec4 quad = texelFetch(packed, cell / 2, 0);
+    ivec2 offset = cell % 2;
+
+    float value = offset.y == 0 ? (offset.x == 0 ? quad.r : quad.g) : (offset.x == 0 ? quad.b : quad.a);
+    FragColor = vec4(value, 0.0, 0.0, 1.0);
+}
\ No newline at end of file
@@ -2,8 +2,10 @@
 
 precision highp float;
 
-uniform sampler2D velocity;
-uniform float gs;
+// STENCIL_TEXEL_FETCH and STENCIL_GATHER select the integer coordinate variants, see CStdGLFluidSolver::SetStencilFetch,
+// which also enables GL_ARB_gpu_shader5 for the gather variant
+
+layout(binding = 0) uniform sampler2D velocity;
 
 varying vec2 coord;
 varying vec2 pxT;
@@ -15,10 +17,35 @@ out vec4 FragColor;
 
 void main()
 {
+#if defined(STENCIL_GATHER)
+    // The gathers around the lower left and upper right corner of the cell return (L, C, B, -) and (T, -, R, C)
+    vec2 size = vec2(textureSize(velocity, 0));
+    vec2 lower = floor(gl_FragCoord.xy) / size;
+    vec2 upper = (floor(gl_FragCoord.xy) + 1.0) / size;
+
+    vec4 lowerX = textureGather(velocity, lower, 0);
+    vec4 upperX = textureGather(velocity, upper, 0);
+    vec4 lowerY = textureGather(velocity, lower, 1);
+    vec4 upperY = textureGather(velocity, upper, 1);
+
+    vec2 R = vec2(upperX.z, upperY.z);
+    vec2 L = vec2(lowerX.x, lowerY.x);
+    vec2 B = vec2(lowerX.z, lowerY.z);
+    vec2 T = vec2(upperX.x, upperY.x);
+#elif defined(STENCIL_TEXEL_FETCH)
+    ivec2 size = textureSize(velocity, 0);
+    ivec2 cell = ivec2(gl_FragCoord.xy);
+
+    vec2 R = texelFetch(velocity, (cell + ivec2(1, 0)) % size, 0).xy;
+    vec2 L = texelFetch(velocity, (cell + ivec2(-1, 0) + size) % size, 0).xy;
+    vec2 B = texelFetch(velocity, (cell + ivec2(0, -1) + size) % size, 0).xy;
+    vec2 T = texelFetch(velocity, (cell + ivec2(0, 1)) % size, 0).xy;
+#else
     vec2 R = texture2D(velocity, pxR).xy;
     vec2 L = texture2D(velocity, pxL).xy;
     vec2 B = texture2D(velocity, pxB).xy;
     vec2 T = texture2D(velocity, pxT).xy;
+#endif
     
     float vorticity = ((R.y - L.y)/(2 * gs)) - ((T.x - B.x)/(2 * gs));
 
@@ -0,0 +1,52 @@
+#version 330 core
+
+precision highp float;
+
+// vorticity.frag and add_vorticity.frag in one pass. The force needs the vorticity of the cell and its four neighbours,
+// which is computed on the fly from the velocity within a radius of two cells.
+
+#define EPSILON 0.00024414
+
+layout(binding = 0) uniform sampler2D velocity;
+
+out vec4 FragColor;
+
+ivec2 size;
+
+vec2 Velocity(ivec2 cell)
+{
+    return texelFetch(velocity, (cell + size) % size, 0).xy;
+}
+
+float Vorticity(ivec2 cell)
+{
+    vec2 R = Velocity(cell + ivec2(1, 0));
+    vec2 L = Velocity(cell + ivec2(-1, 0));
+    vec2 B = Velocity(cell + ivec2(0, -1));
+    vec2 T = Velocity(cell + ivec2(0, 1));
+
+    return ((R.y - L.y)/(2 * gs)) - ((T.x - B.x)/(2 * gs));
+}
+
+void main()
+{
+    size = textureSize(velocity, 0);
+    ivec2 cell = ivec2(gl_FragCoord.xy);
+
+    float R = Vorticity(cell + ivec2(1, 0));
+    float L = Vorticity(cell + ivec2(-1, 0));
+    float B = Vorticity(cell + ivec2(0, -1));
+    float T = Vorticity(cell + ivec2(0, 1));
+    float C = Vorticity(cell);
+
+    vec2 force = vec2(abs(T) - abs(B), abs(R) - abs(L)) / (2 * gs);
+    float mag_sq = max(EPSILON, dot(force,force));
+    force *= inversesqrt(mag_sq);
+    force *= vorticityScale * C * vec2(1,-1);
+
+    vec2 v = Velocity(cell);
+    // Applied once per step, independent of delta_t
+    v += force;
+
+    FragColor = vec4(v, 0.0, 1.0);
+}
\ No newline at end of file